@@ -0,0 +1,15 @@
+#include <cstdio>
+
+extern void bench_Format();
+extern void bench_CsvReader();
+extern void bench_ParallelTokenizer();
+
+int main() {
+  std::puts("== Format");
+  bench_Format();
+  std::puts("== CsvReader");
+  bench_CsvReader();
+  std::puts("== ParallelTokenizer");
+  bench_ParallelTokenizer();
+  return 0;
+}
@@ -0,0 +1,68 @@
+// Measures CsvReader throughput on a generated sensor dump. Build with
+// optimizations, e.g.
+//   zig build bench -Doptimize=ReleaseFast
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <malib/CsvReader.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::size_t Rows = 200'000;
+constexpr std::size_t Repeats = 10;
+
+// Keeps the optimizer from discarding the parsed output
+volatile std::size_t sink_size = 0;
+
+std::string make_dump() {
+  std::string dump{};
+  for (std::size_t i = 0; i < Rows; ++i) {
+    dump += std::to_string(1700000000 + i);
+    dump += ",sensor-";
+    dump += std::to_string(i % 16);
+    dump += ",";
+    dump += std::to_string(20 + (i % 100) / 7.0);
+    dump += ",\"room ";
+    dump += std::to_string(i % 5);
+    dump += ", floor 2\",ok\n";
+  }
+  return dump;
+}
+
+template <typename Fn>
+void run(const char* name, std::size_t bytes, Fn&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < Repeats; ++i) {
+    fn();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto seconds = std::chrono::duration<double>(elapsed).count();
+  std::printf("%-40s %8.1f MB/s\n", name,
+              static_cast<double>(bytes * Repeats) / seconds / 1e6);
+}
+}  // namespace
+
+void bench_CsvReader() {
+  const std::string dump = make_dump();
+
+  run("CsvReader::next (rows)", dump.size(), [&] {
+    malib::CsvReader<8> reader{dump};
+    std::size_t fields = 0;
+    while (auto row = reader.next()) {
+      fields += row->size();
+    }
+    sink_size = fields;
+  });
+
+  run("CsvReader::read_columns (typed)", dump.size(), [&] {
+    static std::vector<long> timestamps(Rows);
+    static std::vector<std::string_view> sensors(Rows);
+    static std::vector<double> values(Rows);
+    malib::CsvReader<8> reader{dump};
+    auto rows = reader.read_columns(std::span{timestamps}, std::span{sensors},
+                                    std::span{values});
+    sink_size = rows.value_or(0);
+  });
+}
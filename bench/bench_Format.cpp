@@ -0,0 +1,67 @@
+// Compares malib::format_to against std::format_to_n for the kind of output
+// shell command handlers produce. Build with optimizations, e.g.
+//   zig build bench -Doptimize=ReleaseFast
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <malib/FixedLengthLinearBuffer.hpp>
+#include <malib/FixedStringBuffer.hpp>
+#include <malib/Format.hpp>
+
+namespace {
+constexpr std::size_t Iterations = 1'000'000;
+
+// Keeps the optimizer from discarding the formatted output
+volatile std::size_t sink_size = 0;
+
+template <typename Fn>
+void run(const char* name, Fn&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < Iterations; ++i) {
+    fn(i);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  std::printf("%-40s %8.2f ns/op\n", name,
+              static_cast<double>(ns) / Iterations);
+}
+}  // namespace
+
+void bench_Format() {
+  run("std::format_to_n (char array)", [](std::size_t i) {
+    std::array<char, 64> out{};
+    auto result = std::format_to_n(out.data(), out.size(),
+                                   "id={} temp={:.2f} name={}", i, 21.5 + i,
+                                   "sensor");
+    sink_size = result.size;
+  });
+
+  run("malib::format_to (FixedLengthLinearBuffer)", [](std::size_t i) {
+    malib::FixedLengthLinearBuffer<char, 64> out;
+    auto result = malib::format_to<"id={} temp={:.2f} name={}">(
+        out, i, 21.5 + i, "sensor");
+    sink_size = result->size;
+  });
+
+  run("malib::format_to (FixedStringBuffer)", [](std::size_t i) {
+    malib::FixedStringBuffer<64> out{};
+    auto result = malib::format_to<"id={} temp={:.2f} name={}">(
+        out, i, 21.5 + i, "sensor");
+    sink_size = result->size;
+  });
+
+  run("std::format_to_n integers only", [](std::size_t i) {
+    std::array<char, 64> out{};
+    auto result =
+        std::format_to_n(out.data(), out.size(), "{} {:x} {}", i, i, -1);
+    sink_size = result.size;
+  });
+
+  run("malib::format_to integers only", [](std::size_t i) {
+    malib::FixedStringBuffer<64> out{};
+    auto result = malib::format_to<"{} {:x} {}">(out, i, i, -1);
+    sink_size = result->size;
+  });
+}
@@ -0,0 +1,47 @@
+// Measures ParallelTokenizer throughput for a growing number of threads on a
+// generated command log. Build with optimizations, e.g.
+//   zig build bench -Doptimize=ReleaseFast
+#include <chrono>
+#include <cstdio>
+#include <malib/ParallelTokenizer.hpp>
+#include <string>
+#include <thread>
+
+namespace {
+constexpr std::size_t Lines = 1'000'000;
+
+// Keeps the optimizer from discarding the tokens
+volatile std::size_t sink_size = 0;
+
+std::string make_log() {
+  std::string log{};
+  for (std::size_t i = 0; i < Lines; ++i) {
+    log += "set sensor-";
+    log += std::to_string(i % 64);
+    log += " threshold ";
+    log += std::to_string(i);
+    log += " \"label with spaces\" --verbose\n";
+  }
+  return log;
+}
+}  // namespace
+
+void bench_ParallelTokenizer() {
+  const std::string log = make_log();
+  const std::size_t max_threads = std::thread::hardware_concurrency();
+
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    malib::ParallelTokenizer<> parallel{threads};
+    const auto start = std::chrono::steady_clock::now();
+    auto total = parallel.tokenize(log);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    sink_size = total.value_or(0);
+
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    char name[40];
+    std::snprintf(name, sizeof(name), "ParallelTokenizer (%zu threads)",
+                  threads);
+    std::printf("%-40s %8.1f MB/s\n", name,
+                static_cast<double>(log.size()) / seconds / 1e6);
+  }
+}
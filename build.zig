@@ -70,6 +70,21 @@ pub fn build(b: *std.Build) void {
             "test_ObservableData.cpp",
             "test_FixedSizeWaitableQueue.cpp",
             "test_FixedLengthLinearBuffer.cpp",
+            "test_ConcurrentLinearBuffer.cpp",
+            "test_ChainedBuffer.cpp",
+            "test_Format.cpp",
+            "test_StreamTokenizer.cpp",
+            "test_TokenRange.cpp",
+            "test_TokenDecoder.cpp",
+            "test_CsvReader.cpp",
+            "test_ParallelTokenizer.cpp",
+            "test_ArgumentParser.cpp",
+            "test_StaticShell.cpp",
+            "test_ShellJobs.cpp",
+            "test_PrefixIndex.cpp",
+            "test_ShellServer.cpp",
+            "test_ShellRpc.cpp",
+            "test_InplaceFunction.cpp",
         },
 
         .flags = &[_][]const u8{
@@ -96,4 +111,36 @@ pub fn build(b: *std.Build) void {
 
     const unity_step = b.step("unity_test", "Run Unity test");
     unity_step.dependOn(&unity_cmd.step);
+
+    const bench_module = b.addModule("bench", .{
+        .target = target,
+        .optimize = optimize,
+        .link_libcpp = true,
+    });
+
+    bench_module.addCSourceFiles(.{
+        .root = b.path("bench"),
+        .files = &[_][]const u8{
+            "bench.cpp",
+            "bench_Format.cpp",
+            "bench_CsvReader.cpp",
+            "bench_ParallelTokenizer.cpp",
+        },
+        .flags = &[_][]const u8{
+            "-std=c++23",
+            "-I",
+            "include",
+        },
+    });
+
+    const bench_exe = b.addExecutable(.{
+        .name = "bench",
+        .root_module = bench_module,
+    });
+
+    bench_exe.linkLibrary(lib);
+
+    const bench_cmd = b.addRunArtifact(bench_exe);
+    const bench_step = b.step("bench", "Run benchmarks");
+    bench_step.dependOn(&bench_cmd.step);
 }
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "malib/Error.hpp"
+#include "malib/PerfectHash.hpp"
+#include "malib/StringConverter.hpp"
+
+namespace malib {
+namespace args {
+
+/**
+ * @brief How an argument is written on the command line
+ */
+enum class kind : std::uint8_t {
+  flag,        ///< --name or -n, sets a bool member
+  option,      ///< --name=value, --name value, name=value, -n value or -nvalue
+  positional,  ///< Any other token, assigned in declaration order
+};
+
+namespace detail {
+template <typename T>
+struct member_traits;
+
+template <typename Struct, typename Field>
+struct member_traits<Field Struct::*> {
+  using struct_type = Struct;
+  using field_type = Field;
+};
+
+template <typename T>
+concept value_field =
+    std::same_as<T, std::string_view> ||
+    (std::integral<T> && !std::same_as<T, bool>) || std::floating_point<T>;
+}  // namespace detail
+
+/**
+ * @brief Describes one argument bound to a member of the result struct
+ */
+template <auto Member, kind Kind>
+struct spec {
+  using struct_type = typename detail::member_traits<
+      decltype(Member)>::struct_type;
+  using field_type = typename detail::member_traits<
+      decltype(Member)>::field_type;
+  static constexpr auto member = Member;
+  static constexpr kind argument_kind = Kind;
+
+  std::string_view name;
+  char short_name;
+};
+
+/**
+ * @brief A switch without a value, stored in a bool member
+ */
+template <auto Member>
+consteval auto flag(std::string_view name, char short_name = '\0') {
+  using field_type = typename detail::member_traits<
+      decltype(Member)>::field_type;
+  static_assert(std::same_as<field_type, bool>, "Flags must be bool members");
+  return spec<Member, kind::flag>{name, short_name};
+}
+
+/**
+ * @brief A named value, converted with StringConverter
+ */
+template <auto Member>
+consteval auto option(std::string_view name, char short_name = '\0') {
+  using field_type = typename detail::member_traits<
+      decltype(Member)>::field_type;
+  static_assert(detail::value_field<field_type>,
+                "Options must be std::string_view or arithmetic members");
+  return spec<Member, kind::option>{name, short_name};
+}
+
+/**
+ * @brief An unnamed value, matched by position
+ */
+template <auto Member>
+consteval auto positional(std::string_view name) {
+  using field_type = typename detail::member_traits<
+      decltype(Member)>::field_type;
+  static_assert(detail::value_field<field_type>,
+                "Positionals must be std::string_view or arithmetic members");
+  return spec<Member, kind::positional>{name, '\0'};
+}
+
+/**
+ * @brief A getopt-style argument parser built from a compile-time schema
+ *
+ * The long names of all flags and options are placed in a perfect hash table
+ * when the schema is built, so resolving a name costs one hash and one string
+ * compare. Short names are looked up in a table indexed by the character.
+ * Parsing makes a single pass over the tokens, converts every value straight
+ * into its member and never allocates.
+ *
+ * Recognized forms: --flag, -f, -abc (several short flags), --option=value,
+ * --option value, -o value, -ovalue and option=value. "--" ends option
+ * parsing; other tokens are positionals. A token of the form key=value whose
+ * key is not an option is a positional too.
+ *
+ * @code
+ * struct copy_args { bool verbose; int count; std::string_view file; };
+ * constexpr malib::args::schema copy_schema{
+ *     malib::args::flag<&copy_args::verbose>("verbose", 'v'),
+ *     malib::args::option<&copy_args::count>("count", 'c'),
+ *     malib::args::positional<&copy_args::file>("file")};
+ * auto parsed = copy_schema.parse(args);  // std::expected<copy_args, Error>
+ * @endcode
+ *
+ * @tparam Struct The result type, default constructible
+ * @tparam Specs The argument specs, see flag(), option() and positional()
+ */
+template <typename Struct, typename... Specs>
+class schema {
+  static_assert(sizeof...(Specs) > 0);
+  static_assert(sizeof...(Specs) < 256);
+  static_assert((std::same_as<typename Specs::struct_type, Struct> && ...),
+                "All specs must bind members of the same struct");
+  static_assert(std::default_initializable<Struct>);
+
+ public:
+  using result_type = Struct;
+
+  consteval explicit schema(Specs... specs)
+      : specs_{specs...}, table_{long_names(specs...)} {
+    collect_specs(std::index_sequence_for<Specs...>{});
+  }
+
+  /**
+   * @brief Parses the arguments into a new Struct
+   *
+   * @param args Any sequence of string_view tokens, e.g. shell::arguments
+   * @return The parsed struct, with members that were not given left
+   * value-initialized, or Error::InvalidArgument for unknown options, missing
+   * or unexpected values and surplus positionals, or the conversion error
+   * reported by StringConverter
+   */
+  template <typename Args>
+  std::expected<Struct, Error> parse(const Args& args) const {
+    Struct result{};
+    std::size_t positional = 0;
+    bool options_done = false;
+
+    auto it = args.begin();
+    const auto end = args.end();
+    while (it != end) {
+      const std::string_view token = *it;
+      ++it;
+
+      // Fetches the value of an option from the next token
+      auto next_value = [&]() -> std::expected<std::string_view, Error> {
+        if (it == end) {
+          return std::unexpected(Error::InvalidArgument);
+        }
+        std::string_view value = *it;
+        ++it;
+        return value;
+      };
+
+      Error error = Error::Ok;
+      if (options_done || !is_option(token)) {
+        error = parse_word(token, result, positional);
+      } else if (token == "--") {
+        options_done = true;
+      } else if (token.starts_with("--")) {
+        error = parse_long(token.substr(2), result, next_value);
+      } else {
+        error = parse_short(token.substr(1), result, next_value);
+      }
+
+      if (error != Error::Ok) {
+        return std::unexpected(error);
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Returns the index of the spec with the given long name
+   */
+  constexpr std::expected<std::size_t, Error> find(
+      std::string_view name) const noexcept {
+    return table_.find(name);
+  }
+
+ private:
+  static constexpr std::size_t SpecCount = sizeof...(Specs);
+  static constexpr std::uint8_t NoSpec = 0xFF;
+
+  static constexpr bool is_option(std::string_view token) noexcept {
+    // "-" alone and negative numbers are values, not options
+    return token.size() > 1 && token[0] == '-' &&
+           !(token[1] >= '0' && token[1] <= '9') && token[1] != '.';
+  }
+
+  template <std::size_t... I>
+  consteval void collect_specs(std::index_sequence<I...>) {
+    ((kinds_[I] = Specs::argument_kind), ...);
+    short_index_.fill(NoSpec);
+
+    auto add_short = [&](char c, std::size_t index) {
+      if (c == '\0') {
+        return;
+      }
+      const auto u = static_cast<unsigned char>(c);
+      if (u >= short_index_.size() || short_index_[u] != NoSpec ||
+          (c >= '0' && c <= '9') || c == '-') {
+        malib::detail::consteval_error("Invalid or duplicate short name");
+      }
+      short_index_[u] = static_cast<std::uint8_t>(index);
+    };
+    (add_short(std::get<I>(specs_).short_name, I), ...);
+
+    (
+        [&] {
+          if (Specs::argument_kind == kind::positional) {
+            positionals_[positional_count_++] = static_cast<std::uint8_t>(I);
+          }
+        }(),
+        ...);
+  }
+
+  /**
+   * @brief Returns the long names of flags and options, indexed like Specs
+   *
+   * Positionals are left empty so that they are not part of the hash table.
+   */
+  static consteval std::array<std::string_view, SpecCount> long_names(
+      const Specs&... specs) {
+    std::array<std::string_view, SpecCount> names{
+        (specs.argument_kind == kind::positional ? std::string_view{}
+                                                  : specs.name)...};
+    for (std::size_t i = 0; i < SpecCount; ++i) {
+      if (names[i].empty() &&
+          std::array<kind, SpecCount>{Specs::argument_kind...}[i] !=
+              kind::positional) {
+        malib::detail::consteval_error("Invalid option name");
+      }
+      if (names[i].find('=') != std::string_view::npos) {
+        malib::detail::consteval_error("Invalid option name");
+      }
+    }
+    return names;
+  }
+
+  template <typename NextValue>
+  Error parse_long(std::string_view body, Struct& result,
+                   NextValue& next_value) const {
+    const auto equals = body.find('=');
+    auto index = find(body.substr(0, equals));
+    if (!index.has_value()) {
+      return index.error();
+    }
+
+    if (kinds_[*index] == kind::flag) {
+      if (equals != std::string_view::npos) {
+        return Error::InvalidArgument;
+      }
+      return assign(*index, result, {});
+    }
+
+    if (equals != std::string_view::npos) {
+      return assign(*index, result, body.substr(equals + 1));
+    }
+    auto value = next_value();
+    if (!value.has_value()) {
+      return value.error();
+    }
+    return assign(*index, result, *value);
+  }
+
+  template <typename NextValue>
+  Error parse_short(std::string_view body, Struct& result,
+                    NextValue& next_value) const {
+    for (std::size_t i = 0; i < body.size(); ++i) {
+      const auto u = static_cast<unsigned char>(body[i]);
+      const auto index = u < short_index_.size() ? short_index_[u] : NoSpec;
+      if (index == NoSpec) {
+        return Error::InvalidArgument;
+      }
+
+      if (kinds_[index] == kind::flag) {
+        assign(index, result, {});
+        continue;
+      }
+
+      // -ovalue, or -o value
+      if (i + 1 < body.size()) {
+        return assign(index, result, body.substr(i + 1));
+      }
+      auto value = next_value();
+      if (!value.has_value()) {
+        return value.error();
+      }
+      return assign(index, result, *value);
+    }
+    return Error::Ok;
+  }
+
+  Error parse_word(std::string_view token, Struct& result,
+                   std::size_t& positional) const {
+    const auto equals = token.find('=');
+    if (equals != std::string_view::npos && equals > 0) {
+      auto index = find(token.substr(0, equals));
+      if (index.has_value() && kinds_[*index] == kind::option) {
+        return assign(*index, result, token.substr(equals + 1));
+      }
+    }
+
+    if (positional >= positional_count_) {
+      return Error::InvalidArgument;
+    }
+    return assign(positionals_[positional++], result, token);
+  }
+
+  Error assign(std::size_t index, Struct& result,
+               std::string_view value) const {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      Error error = Error::InvalidArgument;
+      ((index == I ? (error = assign_to<Specs>(result, value), true) : false) ||
+       ...);
+      return error;
+    }(std::index_sequence_for<Specs...>{});
+  }
+
+  template <typename Spec>
+  static Error assign_to(Struct& result, std::string_view value) {
+    auto& field = result.*Spec::member;
+    using field_type = typename Spec::field_type;
+    if constexpr (Spec::argument_kind == kind::flag) {
+      field = true;
+      return Error::Ok;
+    } else if constexpr (std::same_as<field_type, std::string_view>) {
+      field = value;
+      return Error::Ok;
+    } else {
+      if (value.empty()) {
+        return Error::InvalidArgument;
+      }
+      return StringConverter::to_number_exact(value, field);
+    }
+  }
+
+  std::tuple<Specs...> specs_;
+  std::array<kind, SpecCount> kinds_{};
+  std::array<std::uint8_t, 128> short_index_{};
+  std::array<std::uint8_t, SpecCount> positionals_{};
+  std::size_t positional_count_{0};
+  PerfectHash<SpecCount> table_;
+};
+
+template <typename First, typename... Rest>
+schema(First, Rest...)
+    -> schema<typename First::struct_type, First, Rest...>;
+
+}  // namespace args
+}  // namespace malib
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "malib/Error.hpp"
+#include "malib/concepts.hpp"
+
+namespace malib {
+
+/**
+ * @brief A fixed pool of equally sized buffer segments
+ *
+ * Segments are handed out from an intrusive free list and linked together by
+ * ChainedBuffer. All storage lives inside the pool, so the total memory used
+ * by every buffer drawing from it is bounded at compile time.
+ *
+ * @tparam SegmentSize Number of bytes stored in each segment
+ * @tparam SegmentCount Number of segments in the pool
+ *
+ * Thread safety: acquire() and release() are protected by an internal mutex.
+ */
+template <std::size_t SegmentSize, std::size_t SegmentCount>
+class SegmentPool {
+  static_assert(SegmentSize > 0);
+  static_assert(SegmentCount > 0);
+
+ public:
+  struct Segment {
+    Segment* next{nullptr};
+    std::size_t size{0};
+    std::array<char, SegmentSize> data{};
+
+    std::span<const char> view() const noexcept {
+      return std::span<const char>(data.data(), size);
+    }
+  };
+
+  SegmentPool() noexcept {
+    for (std::size_t i = 0; i + 1 < SegmentCount; ++i) {
+      segments_[i].next = &segments_[i + 1];
+    }
+    free_ = &segments_[0];
+  }
+
+  SegmentPool(const SegmentPool&) = delete;
+  SegmentPool& operator=(const SegmentPool&) = delete;
+
+  /**
+   * @brief Takes an empty segment from the pool
+   * @return The segment, or nullptr if the pool is exhausted
+   */
+  Segment* acquire() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_ == nullptr) {
+      return nullptr;
+    }
+
+    Segment* segment = free_;
+    free_ = segment->next;
+    segment->next = nullptr;
+    segment->size = 0;
+    available_--;
+    return segment;
+  }
+
+  /**
+   * @brief Returns a chain of segments to the pool
+   * @param head The first segment of the chain, may be nullptr
+   */
+  void release(Segment* head) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (head != nullptr) {
+      Segment* next = head->next;
+      head->next = free_;
+      free_ = head;
+      available_++;
+      head = next;
+    }
+  }
+
+  [[nodiscard]] std::size_t available() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return available_;
+  }
+
+  [[nodiscard]] static constexpr std::size_t segment_size() noexcept {
+    return SegmentSize;
+  }
+
+  [[nodiscard]] static constexpr std::size_t capacity() noexcept {
+    return SegmentCount;
+  }
+
+  /**
+   * @brief The pool used by default-constructed ChainedBuffer instances
+   */
+  static SegmentPool& shared() noexcept {
+    static SegmentPool pool{};
+    return pool;
+  }
+
+ private:
+  std::array<Segment, SegmentCount> segments_{};
+  Segment* free_{nullptr};
+  std::size_t available_{SegmentCount};
+  mutable std::mutex mutex_{};
+};
+
+/**
+ * @brief A growable byte buffer made of pool segments linked in a chain
+ *
+ * Writes fill the last segment and link a fresh one from the pool when it is
+ * full, so the buffer grows without ever copying data that was already
+ * written. Memory use follows the amount of data actually written rather than
+ * a worst-case template parameter, which makes it a good fit as the output
+ * buffer of shell::tiny.
+ *
+ * The contents are exposed as a list of contiguous segments, suitable for
+ * vectored writes, through segments() and write_to().
+ *
+ * @tparam SegmentSize Number of bytes stored in each segment
+ * @tparam SegmentCount Number of segments in the backing pool
+ */
+template <std::size_t SegmentSize = 64, std::size_t SegmentCount = 32>
+class ChainedBuffer {
+ public:
+  using pool_type = SegmentPool<SegmentSize, SegmentCount>;
+  using segment_type = typename pool_type::Segment;
+  using value_type = char;
+
+  /**
+   * @brief Forward iterator over the segments of the chain
+   *
+   * Dereferencing yields the written part of a segment as a span.
+   */
+  struct segment_iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::span<const char>;
+    using difference_type = std::ptrdiff_t;
+
+    const segment_type* current{nullptr};
+
+    std::span<const char> operator*() const noexcept {
+      return current->view();
+    }
+
+    segment_iterator& operator++() noexcept {
+      current = current->next;
+      return *this;
+    }
+
+    segment_iterator operator++(int) noexcept {
+      segment_iterator tmp = *this;
+      current = current->next;
+      return tmp;
+    }
+
+    bool operator==(const segment_iterator& other) const noexcept {
+      return current == other.current;
+    }
+  };
+
+  struct segment_range {
+    segment_iterator first;
+
+    segment_iterator begin() const noexcept { return first; }
+    segment_iterator end() const noexcept { return segment_iterator{}; }
+  };
+
+  ChainedBuffer() noexcept : pool_(&pool_type::shared()) {}
+  explicit ChainedBuffer(pool_type& pool) noexcept : pool_(&pool) {}
+  ~ChainedBuffer() noexcept { clear(); }
+
+  ChainedBuffer(const ChainedBuffer&) = delete;
+  ChainedBuffer& operator=(const ChainedBuffer&) = delete;
+
+  ChainedBuffer(ChainedBuffer&& other) noexcept
+      : pool_(other.pool_),
+        head_(std::exchange(other.head_, nullptr)),
+        tail_(std::exchange(other.tail_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        segment_count_(std::exchange(other.segment_count_, 0)) {}
+
+  ChainedBuffer& operator=(ChainedBuffer&& other) noexcept {
+    if (this != &other) {
+      clear();
+      pool_ = other.pool_;
+      head_ = std::exchange(other.head_, nullptr);
+      tail_ = std::exchange(other.tail_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      segment_count_ = std::exchange(other.segment_count_, 0);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Appends bytes to the chain, linking new segments as needed
+   *
+   * If the pool runs out of segments, the bytes that fit are kept and their
+   * count is returned, matching FixedLengthLinearBuffer::write.
+   *
+   * @return The number of bytes written, Error::NullPointerInput if data is
+   * null, or Error::BufferFull if not a single byte could be stored
+   */
+  std::expected<std::size_t, Error> write(const char* data, std::size_t size) {
+    if (data == nullptr) {
+      return std::unexpected(Error::NullPointerInput);
+    }
+
+    std::size_t written = 0;
+    while (written < size) {
+      if (tail_ == nullptr || tail_->size == SegmentSize) {
+        if (!grow()) {
+          break;
+        }
+      }
+
+      const auto chunk = std::min(SegmentSize - tail_->size, size - written);
+      std::memcpy(tail_->data.data() + tail_->size, data + written, chunk);
+      tail_->size += chunk;
+      written += chunk;
+    }
+
+    size_ += written;
+    if (written == 0 && size > 0) {
+      return std::unexpected(Error::BufferFull);
+    }
+    return written;
+  }
+
+  std::expected<std::size_t, Error> write(std::string_view str) {
+    return write(str.data(), str.size());
+  }
+
+  /**
+   * @brief Writes every segment to the given output, in order
+   *
+   * A segment the output only takes in part is written again from where the
+   * output stopped. If the output accepts nothing the remaining segments are
+   * not written, so the output never gets bytes after a gap.
+   *
+   * @return The number of bytes the output accepted, which is less than
+   * size() if it stopped accepting, or the first error reported by the output
+   */
+  template <byte_output_interface Output>
+  std::expected<std::size_t, Error> write_to(Output& output) const {
+    std::size_t total = 0;
+    for (auto segment : segments()) {
+      std::size_t offset = 0;
+      while (offset < segment.size()) {
+        auto result =
+            output.write(segment.data() + offset, segment.size() - offset);
+        std::size_t written = 0;
+        if constexpr (requires { result.has_value(); }) {
+          if (!result.has_value()) {
+            return std::unexpected(result.error());
+          }
+          written = result.value();
+        } else {
+          written = result;
+        }
+        if (written == 0) {
+          return total;
+        }
+        offset += written;
+        total += written;
+      }
+    }
+    return total;
+  }
+
+  /**
+   * @brief Returns the chain as a range of contiguous byte spans
+   */
+  [[nodiscard]] segment_range segments() const noexcept {
+    return segment_range{segment_iterator{head_}};
+  }
+
+  /**
+   * @brief Returns all segments to the pool
+   */
+  void clear() noexcept {
+    pool_->release(head_);
+    head_ = nullptr;
+    tail_ = nullptr;
+    size_ = 0;
+    segment_count_ = 0;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] std::size_t segment_count() const noexcept {
+    return segment_count_;
+  }
+
+ private:
+  bool grow() noexcept {
+    segment_type* segment = pool_->acquire();
+    if (segment == nullptr) {
+      return false;
+    }
+
+    if (tail_ == nullptr) {
+      head_ = segment;
+    } else {
+      tail_->next = segment;
+    }
+    tail_ = segment;
+    segment_count_++;
+    return true;
+  }
+
+  pool_type* pool_;
+  segment_type* head_{nullptr};
+  segment_type* tail_{nullptr};
+  std::size_t size_{0};
+  std::size_t segment_count_{0};
+};
+
+static_assert(output_interface<ChainedBuffer<>>);
+}  // namespace malib
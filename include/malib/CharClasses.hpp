@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace malib {
+
+/**
+ * @brief Character classes understood by the tokenizers
+ *
+ * - Separator: ends a token; runs of separators never produce empty tokens
+ * - Quote: toggles quoting; separators inside quotes do not split a token
+ * - Escape: the following character loses any special meaning
+ */
+enum class CharClass : std::uint8_t {
+  None = 0,
+  Separator = 1 << 0,
+  Quote = 1 << 1,
+  Escape = 1 << 2,
+};
+
+/**
+ * @brief A constexpr 256-entry table mapping every byte to its classes
+ *
+ * Used as a template argument of Tokenizer so that classification is a
+ * single table lookup per byte, fully known at compile time. The classes of a
+ * character are expected to be disjoint.
+ */
+struct CharClassTable {
+  /**
+   * @brief The characters of one class, in ascending byte order
+   */
+  struct Members {
+    std::array<char, 256> chars{};
+    std::size_t size{0};
+  };
+
+  std::array<std::uint8_t, 256> classes{};
+
+  constexpr std::uint8_t operator[](char c) const noexcept {
+    return classes[static_cast<unsigned char>(c)];
+  }
+
+  constexpr bool is(char c, CharClass cls) const noexcept {
+    return ((*this)[c] & static_cast<std::uint8_t>(cls)) != 0;
+  }
+
+  /**
+   * @brief Returns a copy of the table with the given characters added to cls
+   */
+  constexpr CharClassTable with(std::string_view chars,
+                                CharClass cls) const noexcept {
+    CharClassTable result = *this;
+    for (char c : chars) {
+      result.classes[static_cast<unsigned char>(c)] |=
+          static_cast<std::uint8_t>(cls);
+    }
+    return result;
+  }
+
+  constexpr Members members(CharClass cls) const noexcept {
+    Members result{};
+    for (std::size_t i = 0; i < classes.size(); ++i) {
+      if ((classes[i] & static_cast<std::uint8_t>(cls)) != 0) {
+        result.chars[result.size++] = static_cast<char>(i);
+      }
+    }
+    return result;
+  }
+
+  constexpr bool operator==(const CharClassTable&) const = default;
+};
+
+/**
+ * @brief Builds a table from the characters of each class
+ */
+constexpr CharClassTable make_char_classes(std::string_view separators,
+                                           std::string_view quotes = "",
+                                           std::string_view escapes = "") {
+  return CharClassTable{}
+      .with(separators, CharClass::Separator)
+      .with(quotes, CharClass::Quote)
+      .with(escapes, CharClass::Escape);
+}
+
+namespace char_classes {
+/// C-locale whitespace separated, single and double quotes, no escapes
+inline constexpr CharClassTable shell =
+    make_char_classes(" \t\n\v\f\r", "'\"");
+
+/// Like shell, with backslash escapes
+inline constexpr CharClassTable shell_escaped =
+    make_char_classes(" \t\n\v\f\r", "'\"", "\\");
+
+/// Comma separated fields with double quotes. Runs of separators collapse,
+/// so empty fields are skipped.
+inline constexpr CharClassTable csv = make_char_classes(",\r\n", "\"");
+
+/// key=value pairs separated by whitespace, ';' or ','
+inline constexpr CharClassTable key_value =
+    make_char_classes(" \t\r\n=;,", "'\"", "\\");
+
+/// Splits a pipeline into its stages on unquoted '|'; each stage keeps its
+/// surrounding whitespace and is tokenized again with the shell classes
+inline constexpr CharClassTable pipeline = make_char_classes("|", "'\"", "\\");
+}  // namespace char_classes
+
+}  // namespace malib
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include "malib/Error.hpp"
+
+namespace malib {
+
+/**
+ * @brief A fixed-capacity, append-only linear buffer for multiple producers
+ *
+ * Writers reserve space with a compare-exchange on the reserved size, copy
+ * their data in parallel without taking any lock, and then mark their
+ * reservation as ready in a commit record. Every reservation takes a ticket,
+ * and its record lives in a small ring indexed by that ticket. The commit
+ * counter is then advanced over every ready record that follows it, by
+ * whichever writer finds them ready, so a writer never waits for another to
+ * finish copying. A writer that stalls while copying only delays when the
+ * records after it become visible; the committed region [0, size()) never
+ * contains a hole left by a writer that is still copying.
+ *
+ * Readers only ever observe the committed prefix. snapshot() and the iterators
+ * return a consistent view of every record whose reservation, and all
+ * reservations before it, have been committed.
+ *
+ * The ring holds MaxWriters records of 64 bits each, so its size follows the
+ * number of writers in flight rather than Capacity. Once MaxWriters
+ * reservations are waiting to be committed a further writer yields until the
+ * oldest of them is.
+ *
+ * @tparam T The element type
+ * @tparam Capacity The maximum number of elements the buffer can hold
+ * @tparam MaxWriters The number of reservations that may be in flight at once,
+ * a power of two
+ *
+ * Thread safety: write() may be called from any number of threads while
+ * readers call snapshot(), size() and friends. clear() must not race with
+ * write().
+ */
+template <typename T, std::size_t Capacity, std::size_t MaxWriters = 16>
+  requires std::copyable<T>
+class ConcurrentLinearBuffer {
+  static_assert(Capacity > 0);
+  static_assert(Capacity < (std::uint64_t{1} << 40),
+                "offsets are packed into 40 bits");
+  static_assert(MaxWriters > 0 && (MaxWriters & (MaxWriters - 1)) == 0 &&
+                    MaxWriters <= (std::uint64_t{1} << 23),
+                "MaxWriters must be a power of two that fits the ticket");
+
+ public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  ConcurrentLinearBuffer() noexcept = default;
+  ~ConcurrentLinearBuffer() noexcept = default;
+  ConcurrentLinearBuffer(const ConcurrentLinearBuffer&) = delete;
+  ConcurrentLinearBuffer& operator=(const ConcurrentLinearBuffer&) = delete;
+  ConcurrentLinearBuffer(ConcurrentLinearBuffer&&) = delete;
+  ConcurrentLinearBuffer& operator=(ConcurrentLinearBuffer&&) = delete;
+
+  /**
+   * @brief Appends data to the buffer
+   *
+   * The write is all-or-partial: if the reservation straddles the end of the
+   * buffer only the elements that fit are written, matching
+   * FixedLengthLinearBuffer::write.
+   *
+   * @param data Pointer to the elements to append
+   * @param size Number of elements to append
+   * @return The number of elements written, Error::NullPointerInput if data is
+   * null, or Error::BufferFull if no space is left
+   */
+  std::expected<std::size_t, Error> write(const T* data, std::size_t size) {
+    if (data == nullptr) {
+      return std::unexpected(Error::NullPointerInput);
+    }
+
+    if (size == 0) {
+      if (reserved_size() >= Capacity) {
+        return std::unexpected(Error::BufferFull);
+      }
+      return 0;
+    }
+
+    auto state = reserved_.load(std::memory_order_relaxed);
+    std::size_t start = 0;
+    std::size_t write_size = 0;
+    std::uint64_t ticket = 0;
+    for (;;) {
+      start = offset_of(state);
+      if (start >= Capacity) {
+        return std::unexpected(Error::BufferFull);
+      }
+      ticket = ticket_of(state);
+      const auto oldest =
+          ticket_of(committed_.load(std::memory_order_acquire));
+      if (((ticket - oldest) & TicketMask) >= MaxWriters) {
+        // The record this ticket would use still belongs to a reservation
+        // that has not been committed.
+        std::this_thread::yield();
+        state = reserved_.load(std::memory_order_relaxed);
+        continue;
+      }
+      write_size = std::min(Capacity - start, size);
+      if (reserved_.compare_exchange_weak(
+              state, pack(start + write_size, ticket + 1),
+              std::memory_order_relaxed)) {
+        break;
+      }
+    }
+
+    std::copy_n(data, write_size, buffer_.data() + start);
+
+    publish(ticket, write_size);
+    return write_size;
+  }
+
+  std::expected<std::size_t, Error> write(std::string_view str)
+    requires(std::same_as<T, char>)
+  {
+    return write(str.data(), str.size());
+  }
+
+  /**
+   * @brief Returns a view of the committed prefix of the buffer
+   *
+   * Every element in the returned span belongs to a completed write. The view
+   * stays valid until clear() is called.
+   */
+  [[nodiscard]] std::span<const T> snapshot() const noexcept {
+    return std::span<const T>(buffer_.data(), size());
+  }
+
+  std::string_view as_string_view() const noexcept
+    requires(std::same_as<T, char>)
+  {
+    return std::string_view(buffer_.data(), size());
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept {
+    return offset_of(committed_.load(std::memory_order_acquire));
+  }
+
+  [[nodiscard]] constexpr std::size_t capacity() const noexcept {
+    return Capacity;
+  }
+
+  [[nodiscard]] std::size_t free_space() const noexcept {
+    return Capacity - reserved_size();
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] bool full() const noexcept {
+    return reserved_size() == Capacity;
+  }
+
+  /**
+   * @brief Resets the buffer to empty
+   * @warning Must not be called while any write() is in progress.
+   */
+  void clear() noexcept {
+    for (auto& record : records_) {
+      record.store(0, std::memory_order_relaxed);
+    }
+    reserved_.store(0, std::memory_order_relaxed);
+    committed_.store(0, std::memory_order_release);
+  }
+
+  const T* data() const noexcept { return buffer_.data(); }
+
+  const_iterator begin() const noexcept { return buffer_.data(); }
+  const_iterator end() const noexcept { return buffer_.data() + size(); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+ private:
+  // Reservation and commit state pack an element offset in the low 40 bits
+  // and a ticket in the high 24 bits; a commit record packs the ticket it
+  // belongs to with the length of that reservation.
+  static constexpr unsigned OffsetBits = 40;
+  static constexpr std::uint64_t OffsetMask =
+      (std::uint64_t{1} << OffsetBits) - 1;
+  static constexpr std::uint64_t TicketMask =
+      (std::uint64_t{1} << (64 - OffsetBits)) - 1;
+
+  static constexpr std::uint64_t pack(std::uint64_t offset,
+                                      std::uint64_t ticket) noexcept {
+    return ((ticket & TicketMask) << OffsetBits) | offset;
+  }
+  static constexpr std::size_t offset_of(std::uint64_t state) noexcept {
+    return static_cast<std::size_t>(state & OffsetMask);
+  }
+  static constexpr std::uint64_t ticket_of(std::uint64_t state) noexcept {
+    return state >> OffsetBits;
+  }
+
+  std::size_t reserved_size() const noexcept {
+    return offset_of(reserved_.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief Publishes the reservation of size elements taken with ticket
+   *
+   * Fills in the ticket's commit record, then advances the commit counter
+   * over every ready record from where it stands. A record is ready when it
+   * carries the ticket the counter expects next, so a record still holding
+   * the reservation MaxWriters tickets earlier stops the scan. If an earlier
+   * reservation is still being copied the counter stops there, and the
+   * writer of that reservation advances it past this one when it publishes.
+   * The record stores and loads are sequentially consistent, so of two
+   * writers publishing at the same time at least one sees the other's record
+   * and nothing is left behind.
+   */
+  void publish(std::uint64_t ticket, std::size_t size) noexcept {
+    records_[ticket % MaxWriters].store(pack(size, ticket));
+
+    auto committed = committed_.load(std::memory_order_acquire);
+    for (;;) {
+      auto end = committed;
+      while (offset_of(end) < Capacity) {
+        const auto next = ticket_of(end);
+        const auto record = records_[next % MaxWriters].load();
+        if (ticket_of(record) != next || offset_of(record) == 0) {
+          break;
+        }
+        end = pack(offset_of(end) + offset_of(record), next + 1);
+      }
+      if (end == committed ||
+          committed_.compare_exchange_weak(committed, end,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+        return;
+      }
+    }
+  }
+
+  std::atomic<std::uint64_t> reserved_{0};
+  std::atomic<std::uint64_t> committed_{0};
+  std::array<std::atomic<std::uint64_t>, MaxWriters> records_{};
+  std::array<T, Capacity> buffer_{};
+};
+
+}  // namespace malib
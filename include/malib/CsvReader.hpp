@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "malib/Error.hpp"
+#include "malib/Simd.hpp"
+#include "malib/Token.hpp"
+
+namespace malib {
+
+/**
+ * @brief Reads RFC 4180 delimited records one row at a time
+ *
+ * Fields are separated by Delimiter and records by LF or CRLF. A field that
+ * starts with a double quote may contain delimiters, line breaks and doubled
+ * quotes (""); the surrounding quotes are not part of the field, and
+ * decode_field() turns doubled quotes into single ones. Empty fields are kept,
+ * blank lines are skipped.
+ *
+ * Field boundaries are found 64 bytes at a time: the block is classified into
+ * delimiter, newline and quote masks, quoted regions are resolved with a
+ * prefix-XOR over the quote mask, and the remaining boundary bits are consumed
+ * row by row. Each row is returned as TokenViews whose tokens are relative to
+ * the start of the row, so no field is ever copied or allocated.
+ *
+ * @tparam MaxFields Maximum number of fields in a row
+ * @tparam Delimiter The field delimiter, ',' for CSV or '\t' for TSV
+ * @tparam TokenType The token representation, see BasicToken
+ */
+template <std::size_t MaxFields, char Delimiter = ',',
+          typename TokenType = Token>
+class CsvReader {
+  static_assert(Delimiter != '"' && Delimiter != '\n' && Delimiter != '\r');
+
+ public:
+  using row_type = BasicTokenViews<TokenType>;
+
+  explicit CsvReader(std::string_view input) noexcept : input_(input) {}
+
+  /**
+   * @brief Reads the next row
+   *
+   * @return The fields of the row; Error::EmptyInput once all rows were read;
+   * Error::MaximumSizeExceeded if the row has more than MaxFields fields or
+   * Error::ResultOutOfRange if a field does not fit in TokenType. The reader
+   * moves on to the next row after an error.
+   */
+  std::expected<row_type, Error> next() noexcept {
+    while (row_start_ < input_.size()) {
+      Error error = Error::Ok;
+      count_ = 0;
+      std::size_t field_start = row_start_;
+      std::size_t row_end = input_.size();
+      bool newline = false;
+
+      while (true) {
+        const auto boundary = next_boundary();
+        if (boundary >= input_.size()) {
+          break;
+        }
+
+        newline = input_[boundary] == '\n';
+        if (error == Error::Ok) {
+          error = add_field(field_start, boundary, newline);
+        }
+        field_start = boundary + 1;
+        if (newline) {
+          row_end = boundary;
+          break;
+        }
+      }
+
+      if (!newline && error == Error::Ok) {
+        error = add_field(field_start, input_.size(), true);
+      }
+
+      const auto row = input_.substr(row_start_, row_end - row_start_);
+      row_start_ = newline ? row_end + 1 : input_.size();
+      rows_++;
+
+      if (error != Error::Ok) {
+        return std::unexpected(error);
+      }
+
+      // Blank line
+      if (count_ == 1 && tokens_[0].length == 0 && !starts_quoted(row)) {
+        continue;
+      }
+
+      return row_type::create(
+          row, std::span<const TokenType>(tokens_.data(), count_));
+    }
+
+    return std::unexpected(Error::EmptyInput);
+  }
+
+  /**
+   * @brief Reads rows into typed columns until the input or a column runs out
+   *
+   * Field i of every row is converted into the next element of column i.
+   * Arithmetic columns are parsed with std::from_chars and must consume the
+   * whole field; std::string_view columns receive the field as returned by
+   * next(). Fields past the last column are ignored.
+   *
+   * @return The number of rows stored, Error::InvalidArgument if a row has
+   * fewer fields than there are columns or a field is not a valid number, or
+   * Error::ResultOutOfRange if a number does not fit its column type
+   */
+  template <typename... Columns, std::size_t... Extents>
+    requires((std::is_arithmetic_v<Columns> ||
+              std::same_as<Columns, std::string_view>) &&
+             ...)
+  std::expected<std::size_t, Error> read_columns(
+      std::span<Columns, Extents>... columns) noexcept {
+    constexpr std::size_t ColumnCount = sizeof...(Columns);
+    static_assert(ColumnCount > 0 && ColumnCount <= MaxFields);
+
+    const std::size_t capacity = std::min({columns.size()...});
+    std::size_t rows = 0;
+    while (rows < capacity) {
+      auto row = next();
+      if (!row.has_value()) {
+        if (row.error() == Error::EmptyInput) {
+          break;
+        }
+        return std::unexpected(row.error());
+      }
+
+      if (row->size() < ColumnCount) {
+        return std::unexpected(Error::InvalidArgument);
+      }
+
+      Error error = Error::Ok;
+      std::size_t column = 0;
+      ((error = error == Error::Ok
+                    ? parse_field(*(*row)[column++], columns[rows])
+                    : error),
+       ...);
+      if (error != Error::Ok) {
+        return std::unexpected(error);
+      }
+      rows++;
+    }
+    return rows;
+  }
+
+  /**
+   * @brief Replaces doubled quotes in a quoted field with single ones
+   *
+   * Fields without quotes are returned as they are; others are decoded into
+   * arena, whose used bytes are removed from the front.
+   *
+   * @return The decoded field or Error::BufferFull if arena is too small
+   */
+  static std::expected<std::string_view, Error> decode_field(
+      std::string_view field, std::span<char>& arena) noexcept {
+    auto quote = field.find('"');
+    if (quote == std::string_view::npos) {
+      return field;
+    }
+
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < field.size(); ++i) {
+      if (out == arena.size()) {
+        return std::unexpected(Error::BufferFull);
+      }
+      arena[out++] = field[i];
+      if (field[i] == '"' && i + 1 < field.size() && field[i + 1] == '"') {
+        i++;
+      }
+    }
+
+    std::string_view result(arena.data(), out);
+    arena = arena.subspan(out);
+    return result;
+  }
+
+  /**
+   * @brief Returns the number of rows consumed so far, including blank lines
+   * and rows that failed
+   */
+  [[nodiscard]] std::size_t rows() const noexcept { return rows_; }
+
+  /**
+   * @brief Checks whether all rows were read
+   */
+  [[nodiscard]] bool done() const noexcept {
+    return row_start_ >= input_.size();
+  }
+
+ private:
+  static bool starts_quoted(std::string_view row) noexcept {
+    return !row.empty() && row.front() == '"';
+  }
+
+  // A field that ends its row, at a newline or at the end of the input,
+  // drops the \r of a CRLF line ending.
+  Error add_field(std::size_t start, std::size_t end, bool last) noexcept {
+    if (last && end > start && input_[end - 1] == '\r') {
+      end--;
+    }
+    if (end - start >= 2 && input_[start] == '"' && input_[end - 1] == '"') {
+      start++;
+      end--;
+    }
+
+    if (count_ >= MaxFields) {
+      return Error::MaximumSizeExceeded;
+    }
+    const auto offset = start - row_start_;
+    const auto length = end - start;
+    if (!TokenType::fits(offset, length)) {
+      return Error::ResultOutOfRange;
+    }
+    tokens_[count_].offset = offset;
+    tokens_[count_].length = length;
+    count_++;
+    return Error::Ok;
+  }
+
+  template <typename T>
+  static Error parse_field(std::string_view field, T& value) noexcept {
+    if constexpr (std::same_as<T, std::string_view>) {
+      value = field;
+      return Error::Ok;
+    } else if constexpr (std::same_as<T, bool>) {
+      if (field == "1" || field == "true") {
+        value = true;
+      } else if (field == "0" || field == "false") {
+        value = false;
+      } else {
+        return Error::InvalidArgument;
+      }
+      return Error::Ok;
+    } else {
+      const auto end = field.data() + field.size();
+      auto [ptr, ec] = std::from_chars(field.data(), end, value);
+      if (ec == std::errc::result_out_of_range) {
+        return Error::ResultOutOfRange;
+      }
+      if (ec != std::errc{} || ptr != end) {
+        return Error::InvalidArgument;
+      }
+      return Error::Ok;
+    }
+  }
+
+  /**
+   * @brief Returns the position of the next unquoted delimiter or newline,
+   * or a position past the input if there is none
+   */
+  std::size_t next_boundary() noexcept {
+    while (boundaries_ == 0) {
+      if (block_base_ >= input_.size()) {
+        return input_.size();
+      }
+      boundaries_ = classify(block_base_);
+      current_base_ = block_base_;
+      block_base_ += simd::BlockSize;
+    }
+
+    const auto pos = current_base_ + std::countr_zero(boundaries_);
+    boundaries_ &= boundaries_ - 1;
+    return pos;
+  }
+
+  /**
+   * @brief Returns the mask of unquoted delimiters and newlines in the block
+   * starting at base
+   */
+  std::uint64_t classify(std::size_t base) noexcept {
+    const auto remaining = input_.size() - base;
+    const char* block = input_.data() + base;
+    // The tail is padded with NULs, which are never boundaries
+    alignas(32) char tail[simd::BlockSize]{};
+    if (remaining < simd::BlockSize) {
+      std::memcpy(tail, block, remaining);
+      block = tail;
+    }
+
+    std::uint64_t quote = 0;
+    std::uint64_t boundary = 0;
+#if MALIB_SIMD
+    quote = simd::match_block(block, '"');
+    boundary = simd::match_block(block, Delimiter) |
+               simd::match_block(block, '\n');
+#else
+    for (std::size_t i = 0; i < simd::BlockSize; ++i) {
+      quote |= static_cast<std::uint64_t>(block[i] == '"') << i;
+      boundary |= static_cast<std::uint64_t>(block[i] == Delimiter ||
+                                             block[i] == '\n')
+                  << i;
+    }
+#endif
+
+    // Doubled quotes toggle twice, so they never change the quoted state
+    const std::uint64_t inside = simd::prefix_xor(quote) ^ quote_state_;
+    quote_state_ =
+        static_cast<std::uint64_t>(static_cast<std::int64_t>(inside) >> 63);
+    return boundary & ~inside;
+  }
+
+  std::string_view input_;
+  std::size_t row_start_{0};
+  std::size_t block_base_{0};    // start of the next block to classify
+  std::size_t current_base_{0};  // start of the block in boundaries_
+  std::uint64_t boundaries_{0};
+  std::uint64_t quote_state_{0};  // all ones while inside quotes
+  std::size_t rows_{0};
+  std::array<TokenType, MaxFields> tokens_{};
+  std::size_t count_{0};
+};
+
+/**
+ * @brief A CsvReader for tab separated values
+ */
+template <std::size_t MaxFields, typename TokenType = Token>
+using TsvReader = CsvReader<MaxFields, '\t', TokenType>;
+
+}  // namespace malib
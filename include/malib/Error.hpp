@@ -19,4 +19,11 @@ enum class Error : std::int32_t {
   ResultOutOfRange,
   QueueFull,
 };
+
+namespace detail {
+// Deliberately not constexpr: reaching it during constant evaluation, while
+// parsing a format string or building a table at compile time, is a compile
+// error that names this function and shows the message at the call.
+inline void consteval_error(const char* message) { (void)message; }
+}  // namespace detail
 };
\ No newline at end of file
@@ -131,21 +131,10 @@ class FixedLengthLinearBuffer {
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
   // Iterator methods
-  iterator begin() noexcept {
-    if constexpr (ThreadSafe) {
-      lock_guard lock(mutex_);
-      return buffer_.data();
-    }
-    return buffer_.data();
-  }
+  // The storage never moves, so begin() does not need the lock.
+  iterator begin() noexcept { return buffer_.data(); }
 
-  const_iterator begin() const noexcept {
-    if constexpr (ThreadSafe) {
-      lock_guard lock(mutex_);
-      return buffer_.data();
-    }
-    return buffer_.data();
-  }
+  const_iterator begin() const noexcept { return buffer_.data(); }
 
   const_iterator cbegin() const noexcept { return begin(); }
 
@@ -185,18 +174,10 @@ class FixedLengthLinearBuffer {
 
   // Keep the format_begin/end methods public
   sizing_iterator format_begin() noexcept {
-    if constexpr (ThreadSafe) {
-      lock_guard lock(mutex_);
-      return sizing_iterator(buffer_.data(), this);
-    }
     return sizing_iterator(buffer_.data(), this);
   }
 
   sizing_iterator format_end() noexcept {
-    if constexpr (ThreadSafe) {
-      lock_guard lock(mutex_);
-      return sizing_iterator(buffer_.data() + Capacity, this);
-    }
     return sizing_iterator(buffer_.data() + Capacity, this);
   }
 
@@ -221,7 +202,9 @@ class FixedLengthLinearBuffer {
  private:
   std::expected<std::size_t, Error> write_impl(const T* data,
                                                std::size_t size) {
-    if (full()) {
+    // Called with the lock already held, so the locking full() must not be
+    // used here.
+    if (current_size_ == Capacity) {
       return std::unexpected(Error::BufferFull);
     }
 
@@ -241,7 +224,7 @@ class FixedLengthLinearBuffer {
 
   template <typename U>
   std::expected<std::size_t, Error> write_move_impl(U* data, std::size_t size) {
-    if (full()) {
+    if (current_size_ == Capacity) {
       return std::unexpected(Error::BufferFull);
     }
 
@@ -256,7 +239,7 @@ class FixedLengthLinearBuffer {
   }
 
   std::expected<std::size_t, Error> read_impl(T* data, std::size_t size) {
-    if (empty()) {
+    if (current_size_ == 0) {
       return std::unexpected(Error::BufferEmpty);
     }
 
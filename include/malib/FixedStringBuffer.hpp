@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
-#include <cstring>
+#include <expected>
+#include <string_view>
 
 #include "malib/Error.hpp"
 #include "malib/concepts.hpp"
@@ -29,7 +31,7 @@ struct FixedStringBuffer {
     }
   }
 
-  Error copy(std_string auto value) {
+  constexpr Error copy(std_string auto value) {
     if constexpr (std::is_same_v<std::remove_cv_t<
                                      std::remove_reference_t<decltype(value)>>,
                                  std::string>) {
@@ -39,7 +41,7 @@ struct FixedStringBuffer {
     }
   }
 
-  Error copy(c_str auto value, std::size_t size) {
+  constexpr Error copy(c_str auto value, std::size_t size) {
     if (value == nullptr) {
       return Error::NullPointerInput;
     }
@@ -48,83 +50,94 @@ struct FixedStringBuffer {
       return Error::MaximumSizeExceeded;
     }
 
-    std::memcpy(buf_.data(), value, size);
+    std::copy_n(value, size, buf_.data());
     size_ = size;
     return Error::Ok;
   }
 
-  std::string_view view() const noexcept {
+  constexpr std::string_view view() const noexcept {
     return std::string_view{buf_.data(), size_};
   }
 
-  void reset() {
+  constexpr void reset() {
     size_ = 0;
     buf_ = {0};
   }
 
-  void clear() { reset(); }
+  constexpr void clear() { reset(); }
 
-  [[nodiscard]] iterator begin() noexcept { return buf_.begin(); }
-  [[nodiscard]] iterator end() noexcept { return buf_.begin() + size_; }
+  [[nodiscard]] constexpr iterator begin() noexcept { return buf_.begin(); }
+  [[nodiscard]] constexpr iterator end() noexcept {
+    return buf_.begin() + size_;
+  }
 
-  [[nodiscard]] const_iterator cbegin() const noexcept { return buf_.cbegin(); }
-  [[nodiscard]] const_iterator cend() const noexcept {
+  [[nodiscard]] constexpr const_iterator cbegin() const noexcept {
+    return buf_.cbegin();
+  }
+  [[nodiscard]] constexpr const_iterator cend() const noexcept {
     return buf_.cbegin() + size_;
   }
 
-  [[nodiscard]] const_iterator begin() const noexcept { return cbegin(); }
-  [[nodiscard]] const_iterator end() const noexcept { return cend(); }
+  [[nodiscard]] constexpr const_iterator begin() const noexcept {
+    return cbegin();
+  }
+  [[nodiscard]] constexpr const_iterator end() const noexcept {
+    return cend();
+  }
 
-  [[nodiscard]] iterator data() noexcept { return begin(); }
+  [[nodiscard]] constexpr iterator data() noexcept { return begin(); }
 
-  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return size_; }
 
-  [[nodiscard]] std::size_t capacity() const noexcept { return MaxSize; }
+  [[nodiscard]] constexpr std::size_t capacity() const noexcept {
+    return MaxSize;
+  }
 
-  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] constexpr bool empty() const noexcept { return size_ == 0; }
 
-  [[nodiscard]] bool full() const noexcept { return size_ == MaxSize; }
+  [[nodiscard]] constexpr bool full() const noexcept {
+    return size_ == MaxSize;
+  }
 
-  [[nodiscard]] char& operator[](std::size_t index) { return buf_[index]; }
+  [[nodiscard]] constexpr char& operator[](std::size_t index) {
+    return buf_[index];
+  }
 
-  [[nodiscard]] const char& operator[](std::size_t index) const {
+  [[nodiscard]] constexpr const char& operator[](std::size_t index) const {
     return buf_[index];
   }
 
-  [[nodiscard]] bool operator==(const FixedStringBuffer& other) const {
+  [[nodiscard]] constexpr bool operator==(
+      const FixedStringBuffer& other) const {
     return view() == other.view();
   }
 
-  [[nodiscard]] bool operator!=(const FixedStringBuffer& other) const {
+  [[nodiscard]] constexpr bool operator!=(
+      const FixedStringBuffer& other) const {
     return view() != other.view();
   }
 
-  std::expected<std::size_t, Error> write(const char* data, std::size_t size) {
+  constexpr std::expected<std::size_t, Error> write(const char* data,
+                                                   std::size_t size) {
     if (data == nullptr) {
       return std::unexpected(Error::NullPointerInput);
     }
 
-    if (size + size_ > MaxSize) {
+    if (size > MaxSize - size_) {
       return std::unexpected(Error::MaximumSizeExceeded);
     }
 
-    if (size > 1) {
-      std::memcpy(buf_.data() + size_, data, size);
-      size_ += size;
-    } else {
-      buf_[size_] = *data;
-      ++size_;
-    }
-
+    std::copy_n(data, size, buf_.data() + size_);
+    size_ += size;
     return size;
   }
 
-  std::expected<std::size_t, Error> write(std::string_view str) {
-    if (str.size() + size_ > MaxSize) {
+  constexpr std::expected<std::size_t, Error> write(std::string_view str) {
+    if (str.size() > MaxSize - size_) {
       return std::unexpected(Error::MaximumSizeExceeded);
     }
 
-    std::memcpy(buf_.data() + size_, str.data(), str.size());
+    std::copy_n(str.data(), str.size(), buf_.data() + size_);
     size_ += str.size();
     return str.size();
   }
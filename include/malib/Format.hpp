@@ -0,0 +1,651 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "malib/Error.hpp"
+#include "malib/concepts.hpp"
+
+namespace malib {
+
+/**
+ * @brief A string literal usable as a template argument
+ *
+ * Allows format strings to be passed as non-type template parameters so they
+ * can be parsed entirely at compile time, e.g. `format_to<"{} {}">(out, a, b)`.
+ */
+template <std::size_t N>
+struct format_string {
+  char value[N]{};
+
+  consteval format_string(const char (&str)[N]) {
+    for (std::size_t i = 0; i < N; ++i) {
+      value[i] = str[i];
+    }
+  }
+
+  constexpr std::string_view view() const noexcept {
+    return std::string_view(value, N - 1);
+  }
+};
+
+/**
+ * @brief The outcome of a format_to call
+ *
+ * `size` is the length the fully formatted output would have, `written` is
+ * how much of it the output accepted. Output is truncated when the two differ.
+ */
+struct format_result {
+  std::size_t written{0};
+  std::size_t size{0};
+
+  [[nodiscard]] bool truncated() const noexcept { return written < size; }
+};
+
+namespace format_detail {
+
+struct spec {
+  char fill{' '};
+  char align{'\0'};
+  bool zero{false};
+  std::size_t width{0};
+  int precision{-1};
+  char type{'\0'};
+};
+
+struct segment {
+  bool is_argument{false};
+  std::size_t offset{0};
+  std::size_t length{0};
+  std::size_t argument{0};
+  spec format{};
+};
+
+consteval bool is_align(char c) { return c == '<' || c == '>' || c == '^'; }
+
+consteval bool is_type(char c) {
+  return std::string_view("bdoxXfFeEgGsc").find(c) != std::string_view::npos;
+}
+
+consteval spec parse_spec(std::string_view text) {
+  spec result{};
+  std::size_t pos = 0;
+
+  if (text.size() >= 2 && is_align(text[1])) {
+    result.fill = text[0];
+    result.align = text[1];
+    pos = 2;
+  } else if (!text.empty() && is_align(text[0])) {
+    result.align = text[0];
+    pos = 1;
+  }
+
+  if (pos < text.size() && text[pos] == '0') {
+    result.zero = true;
+    pos++;
+  }
+
+  while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+    result.width = result.width * 10 + (text[pos] - '0');
+    pos++;
+  }
+
+  if (pos < text.size() && text[pos] == '.') {
+    pos++;
+    if (pos >= text.size() || text[pos] < '0' || text[pos] > '9') {
+      detail::consteval_error("malib::format: missing precision after '.'");
+    }
+    result.precision = 0;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+      result.precision = result.precision * 10 + (text[pos] - '0');
+      pos++;
+    }
+  }
+
+  if (pos < text.size()) {
+    if (!is_type(text[pos])) {
+      detail::consteval_error("malib::format: unknown presentation type");
+    }
+    result.type = text[pos];
+    pos++;
+  }
+
+  if (pos != text.size()) {
+    detail::consteval_error("malib::format: invalid format specification");
+  }
+
+  return result;
+}
+
+/**
+ * @brief Walks a format string, calling emit for every segment
+ *
+ * Shared by the counting and the parsing pass so both agree exactly.
+ */
+template <typename Emit>
+consteval void walk(std::string_view fmt, Emit emit) {
+  std::size_t pos = 0;
+  std::size_t literal_start = 0;
+  std::size_t argument = 0;
+
+  auto flush_literal = [&](std::size_t end) {
+    if (end > literal_start) {
+      emit(segment{false, literal_start, end - literal_start, 0, {}});
+    }
+  };
+
+  while (pos < fmt.size()) {
+    const char c = fmt[pos];
+    if (c == '{' && pos + 1 < fmt.size() && fmt[pos + 1] == '{') {
+      flush_literal(pos + 1);
+      pos += 2;
+      literal_start = pos;
+    } else if (c == '}' && pos + 1 < fmt.size() && fmt[pos + 1] == '}') {
+      flush_literal(pos + 1);
+      pos += 2;
+      literal_start = pos;
+    } else if (c == '{') {
+      flush_literal(pos);
+      const auto close = fmt.find('}', pos);
+      if (close == std::string_view::npos) {
+        detail::consteval_error(
+            "malib::format: unterminated replacement field");
+      }
+
+      auto field = fmt.substr(pos + 1, close - pos - 1);
+      spec field_spec{};
+      if (!field.empty()) {
+        if (field[0] != ':') {
+          detail::consteval_error(
+              "malib::format: only automatic field numbering");
+        }
+        field_spec = parse_spec(field.substr(1));
+      }
+
+      emit(segment{true, pos, close - pos + 1, argument++, field_spec});
+      pos = close + 1;
+      literal_start = pos;
+    } else if (c == '}') {
+      detail::consteval_error("malib::format: unmatched '}'");
+    } else {
+      pos++;
+    }
+  }
+
+  flush_literal(pos);
+}
+
+consteval std::size_t count_segments(std::string_view fmt) {
+  std::size_t count = 0;
+  walk(fmt, [&](segment) { count++; });
+  return count;
+}
+
+consteval std::size_t count_arguments(std::string_view fmt) {
+  std::size_t count = 0;
+  walk(fmt, [&](segment s) { count += s.is_argument ? 1 : 0; });
+  return count;
+}
+
+template <std::size_t Count>
+consteval std::array<segment, Count> parse(std::string_view fmt) {
+  std::array<segment, Count> segments{};
+  std::size_t idx = 0;
+  walk(fmt, [&](segment s) { segments[idx++] = s; });
+  return segments;
+}
+
+/**
+ * @brief Adapts any output_interface for formatting
+ *
+ * Tracks the untruncated size and stops writing as soon as the output is
+ * full. Outputs that report capacity() and size() get their writes clamped up
+ * front, so all-or-nothing buffers such as FixedStringBuffer still receive the
+ * part that fits.
+ */
+template <typename Output>
+struct sink {
+  Output& output;
+  format_result result{};
+  Error error{Error::Ok};
+  bool stopped{false};
+
+  void put(const char* data, std::size_t size) {
+    result.size += size;
+    if (stopped || size == 0) {
+      return;
+    }
+
+    std::size_t allowed = size;
+    if constexpr (requires {
+                    { output.capacity() } -> std::convertible_to<std::size_t>;
+                    { output.size() } -> std::convertible_to<std::size_t>;
+                  }) {
+      const std::size_t room = output.capacity() - output.size();
+      if (room < allowed) {
+        allowed = room;
+        stopped = true;
+      }
+      if (allowed == 0) {
+        return;
+      }
+    }
+
+    auto written = output.write(data, allowed);
+    if constexpr (requires { written.has_value(); }) {
+      if (!written.has_value()) {
+        stopped = true;
+        if (written.error() != Error::BufferFull &&
+            written.error() != Error::MaximumSizeExceeded) {
+          error = written.error();
+        }
+        return;
+      }
+      result.written += written.value();
+      if (written.value() < allowed) {
+        stopped = true;
+      }
+    } else {
+      result.written += static_cast<std::size_t>(written);
+      if (static_cast<std::size_t>(written) < allowed) {
+        stopped = true;
+      }
+    }
+  }
+
+  void fill(char c, std::size_t count) {
+    std::array<char, 16> chunk{};
+    chunk.fill(c);
+    while (count > 0) {
+      const auto n = count < chunk.size() ? count : chunk.size();
+      put(chunk.data(), n);
+      count -= n;
+    }
+  }
+
+  void padded(const char* data, std::size_t size, const spec& s,
+              char default_align) {
+    if (s.width <= size) {
+      put(data, size);
+      return;
+    }
+
+    const auto padding = s.width - size;
+    const char align = s.align == '\0' ? default_align : s.align;
+    const auto before = align == '>'   ? padding
+                        : align == '^' ? padding / 2
+                                       : 0;
+    fill(s.fill, before);
+    put(data, size);
+    fill(s.fill, padding - before);
+  }
+
+  /**
+   * @brief Pads a formatted number, honouring the 0 flag
+   *
+   * With the 0 flag and no explicit alignment the number is padded with
+   * zeros between its sign and its digits, as std::format does; otherwise
+   * it is aligned like any other field.
+   */
+  void padded_number(const char* data, std::size_t size, const spec& s) {
+    if (!s.zero || s.align != '\0' || s.width <= size) {
+      padded(data, size, s, '>');
+      return;
+    }
+
+    std::size_t sign = size > 0 && data[0] == '-' ? 1 : 0;
+    put(data, sign);
+    fill('0', s.width - size);
+    put(data + sign, size - sign);
+  }
+};
+
+template <typename T>
+concept string_like = std::convertible_to<const T&, std::string_view> &&
+                      !std::same_as<std::remove_cvref_t<T>, char>;
+
+/**
+ * @brief The argument categories that decide which specs are valid
+ */
+enum class argument_kind { boolean, character, integer, floating, string };
+
+template <typename T>
+consteval argument_kind kind_of() {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::same_as<U, bool>) {
+    return argument_kind::boolean;
+  } else if constexpr (std::same_as<U, char>) {
+    return argument_kind::character;
+  } else if constexpr (std::integral<U>) {
+    return argument_kind::integer;
+  } else if constexpr (std::floating_point<U>) {
+    return argument_kind::floating;
+  } else {
+    static_assert(string_like<U>, "malib::format: unsupported argument type");
+    return argument_kind::string;
+  }
+}
+
+/**
+ * @brief Checks a spec against the argument it formats, with the rules of
+ * std::format
+ *
+ * With report set an invalid spec is a compile error naming the problem,
+ * otherwise it only makes the result false.
+ */
+consteval bool check_spec(const spec& s, argument_kind kind, bool report) {
+  const auto allows = [&s](std::string_view types) {
+    return s.type == '\0' || types.find(s.type) != std::string_view::npos;
+  };
+  switch (kind) {
+    case argument_kind::boolean:
+      if (!allows("sbdoxX")) {
+        if (report) {
+          detail::consteval_error(
+              "malib::format: invalid presentation type for bool");
+        }
+        return false;
+      }
+      break;
+    case argument_kind::character:
+      if (!allows("cbdoxX")) {
+        if (report) {
+          detail::consteval_error(
+              "malib::format: invalid presentation type for char");
+        }
+        return false;
+      }
+      break;
+    case argument_kind::integer:
+      if (!allows("bcdoxX")) {
+        if (report) {
+          detail::consteval_error(
+              "malib::format: invalid presentation type for an integer");
+        }
+        return false;
+      }
+      break;
+    case argument_kind::floating:
+      if (!allows("eEfFgG")) {
+        if (report) {
+          detail::consteval_error(
+              "malib::format: invalid presentation type for a floating point "
+              "value");
+        }
+        return false;
+      }
+      break;
+    case argument_kind::string:
+      if (!allows("s")) {
+        if (report) {
+          detail::consteval_error(
+              "malib::format: invalid presentation type for a string");
+        }
+        return false;
+      }
+      break;
+  }
+  if (s.precision >= 0 && kind != argument_kind::floating &&
+      kind != argument_kind::string) {
+    if (report) {
+      detail::consteval_error(
+          "malib::format: precision is only valid for floating point values "
+          "and strings");
+    }
+    return false;
+  }
+  const bool numeric =
+      kind == argument_kind::floating ||
+      (kind == argument_kind::integer && s.type != 'c') ||
+      ((kind == argument_kind::boolean || kind == argument_kind::character) &&
+       s.type != '\0' && s.type != 's' && s.type != 'c');
+  if (s.zero && !numeric) {
+    if (report) {
+      detail::consteval_error(
+          "malib::format: the 0 flag is only valid for numbers");
+    }
+    return false;
+  }
+  return true;
+}
+
+template <typename Output, typename T>
+void format_integer(sink<Output>& out, const spec& s, T value) {
+  int base = 10;
+  switch (s.type) {
+    case 'b': base = 2; break;
+    case 'o': base = 8; break;
+    case 'x':
+    case 'X': base = 16; break;
+    default: break;
+  }
+
+  std::array<char, sizeof(T) * 8 + 1> buf{};
+  auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), value,
+                                 base);
+  if (s.type == 'X') {
+    for (char* p = buf.data(); p != end; ++p) {
+      if (*p >= 'a' && *p <= 'f') {
+        *p = static_cast<char>(*p - 'a' + 'A');
+      }
+    }
+  }
+  out.padded_number(buf.data(), end - buf.data(), s);
+}
+
+constexpr bool is_integer_type(char type) {
+  return type == 'b' || type == 'd' || type == 'o' || type == 'x' ||
+         type == 'X';
+}
+
+template <typename Output, typename T>
+void format_value(sink<Output>& out, const spec& s, const T& value) {
+  using U = std::remove_cvref_t<T>;
+
+  if constexpr (std::same_as<U, bool>) {
+    if (is_integer_type(s.type)) {
+      format_integer(out, s, static_cast<unsigned char>(value));
+      return;
+    }
+    const std::string_view text = value ? "true" : "false";
+    out.padded(text.data(), text.size(), s, '<');
+  } else if constexpr (std::same_as<U, char>) {
+    if (is_integer_type(s.type)) {
+      format_integer(out, s, static_cast<unsigned char>(value));
+      return;
+    }
+    out.padded(&value, 1, s, '<');
+  } else if constexpr (std::integral<U>) {
+    if (s.type == 'c') {
+      constexpr int min = std::numeric_limits<char>::min();
+      constexpr int max = std::numeric_limits<char>::max();
+      if (std::cmp_less(value, min) || std::cmp_greater(value, max)) {
+        out.error = Error::ResultOutOfRange;
+        out.stopped = true;
+        return;
+      }
+      const char c = static_cast<char>(value);
+      out.padded(&c, 1, s, '<');
+      return;
+    }
+    format_integer(out, s, value);
+  } else if constexpr (std::floating_point<U>) {
+    std::array<char, 64> buf{};
+    std::to_chars_result r{};
+    auto* first = buf.data();
+    auto* last = buf.data() + buf.size();
+    const int precision = s.precision < 0 ? 6 : s.precision;
+
+    switch (s.type) {
+      case 'f':
+      case 'F':
+        r = std::to_chars(first, last, value, std::chars_format::fixed,
+                          precision);
+        break;
+      case 'e':
+      case 'E':
+        r = std::to_chars(first, last, value, std::chars_format::scientific,
+                          precision);
+        break;
+      case 'g':
+      case 'G':
+        r = std::to_chars(first, last, value, std::chars_format::general,
+                          precision);
+        break;
+      default:
+        r = s.precision < 0
+                ? std::to_chars(first, last, value)
+                : std::to_chars(first, last, value, std::chars_format::general,
+                                precision);
+        break;
+    }
+
+    if (r.ec != std::errc{}) {
+      out.error = Error::ResultOutOfRange;
+      out.stopped = true;
+      return;
+    }
+
+    if (s.type == 'F' || s.type == 'E' || s.type == 'G') {
+      for (char* p = first; p != r.ptr; ++p) {
+        if (*p >= 'a' && *p <= 'z') {
+          *p = static_cast<char>(*p - 'a' + 'A');
+        }
+      }
+    }
+    if (std::isfinite(value)) {
+      out.padded_number(first, r.ptr - first, s);
+    } else {
+      out.padded(first, r.ptr - first, s, '>');
+    }
+  } else if constexpr (string_like<U>) {
+    std::string_view text{value};
+    if (s.precision >= 0 &&
+        static_cast<std::size_t>(s.precision) < text.size()) {
+      text = text.substr(0, s.precision);
+    }
+    out.padded(text.data(), text.size(), s, '<');
+  } else {
+    static_assert(sizeof(U) == 0, "malib::format: unsupported argument type");
+  }
+}
+
+template <format_string Fmt>
+struct parsed {
+  static constexpr auto text = Fmt.view();
+  static constexpr auto segments =
+      parse<count_segments(Fmt.view())>(Fmt.view());
+  static constexpr std::size_t arguments = count_arguments(Fmt.view());
+};
+
+/**
+ * @brief Checks the spec of every replacement field of Fmt against the type
+ * of its argument in Args
+ */
+template <format_string Fmt, typename... Args>
+consteval bool check_arguments(bool report) {
+  constexpr std::array<argument_kind, sizeof...(Args)> kinds{
+      kind_of<Args>()...};
+  for (const auto& segment : parsed<Fmt>::segments) {
+    if (segment.is_argument && segment.argument < kinds.size() &&
+        !check_spec(segment.format, kinds[segment.argument], report)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief True if every spec of Fmt is valid for its argument in Args
+ */
+template <format_string Fmt, typename... Args>
+inline constexpr bool accepts = check_arguments<Fmt, Args...>(false);
+
+}  // namespace format_detail
+
+/**
+ * @brief Formats arguments into any output_interface without allocating
+ *
+ * The format string is a template argument and is parsed and validated at
+ * compile time; the call expands to a fixed sequence of bulk writes, one per
+ * literal run and one per argument. Integers and floats are rendered with
+ * std::to_chars into a small stack buffer.
+ *
+ * Supported replacement fields follow std::format: `{}` or
+ * `{:[[fill]align][0][width][.precision][type]}` with automatic numbering and
+ * types b, d, o, x, X, f, F, e, E, g, G, s and c. Each spec is checked
+ * against the type of its argument as std::format does, so a float type on
+ * an integer or a precision on anything but floats and strings does not
+ * compile. Integer types print a bool or a char as its numeric value and c
+ * prints an integer as a character. The 0 flag pads a number with zeros after
+ * its sign, is ignored when an alignment is given and, like std::format,
+ * does not compile for strings, characters or bools.
+ *
+ * Truncation is not an error: the returned format_result reports how many
+ * bytes were written and how many the full output needs.
+ *
+ * @code
+ * malib::FixedStringBuffer<32> out{};
+ * auto result = malib::format_to<"temp={:.1f}C">(out, 21.5);
+ * @endcode
+ *
+ * @return The format_result, or the error reported by the output if it failed
+ * for a reason other than running out of space. Error::ResultOutOfRange if a
+ * floating point value does not fit the 64 character conversion buffer, or
+ * if an integer printed with c is not a valid char.
+ */
+template <format_string Fmt, output_interface Output, typename... Args>
+std::expected<format_result, Error> format_to(Output& output,
+                                              const Args&... args) {
+  using parsed = format_detail::parsed<Fmt>;
+  static_assert(parsed::arguments == sizeof...(Args),
+                "malib::format: argument count does not match format string");
+  static_assert(format_detail::check_arguments<Fmt, Args...>(true));
+
+  format_detail::sink<Output> out{output};
+  const auto values = std::forward_as_tuple(args...);
+
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (
+        [&] {
+          constexpr auto segment = parsed::segments[I];
+          if constexpr (segment.is_argument) {
+            format_detail::format_value(out, segment.format,
+                                        std::get<segment.argument>(values));
+          } else {
+            out.put(parsed::text.data() + segment.offset, segment.length);
+          }
+        }(),
+        ...);
+  }(std::make_index_sequence<parsed::segments.size()>{});
+
+  if (out.error != Error::Ok) {
+    return std::unexpected(out.error);
+  }
+  return out.result;
+}
+
+/**
+ * @brief Returns the length of the formatted output without writing it
+ */
+template <format_string Fmt, typename... Args>
+std::size_t formatted_size(const Args&... args) {
+  struct counter {
+    std::size_t write(const char*, std::size_t size) { return size; }
+    std::size_t write(std::string_view str) { return str.size(); }
+  } counting{};
+  auto result = format_to<Fmt>(counting, args...);
+  return result.has_value() ? result->size : 0;
+}
+
+}  // namespace malib
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace malib {
+
+template <typename Signature, std::size_t Capacity = 32,
+          std::size_t Alignment = alignof(std::max_align_t)>
+class inplace_function;
+
+/**
+ * @brief A move-only function wrapper that stores its callable inside itself
+ *
+ * Like std::function, but the callable lives in a buffer of Capacity bytes
+ * within the object, so constructing, moving and calling never allocate.
+ * Callables that are larger than Capacity, need a stricter alignment or may
+ * throw when moved are rejected with a static_assert instead of falling back
+ * to the heap. Callables that are trivially copyable, such as lambdas that
+ * capture pointers and references, are moved with a plain copy of the
+ * buffer; only others go through a type-erased move and destroy.
+ *
+ * Calling an empty inplace_function is undefined; compare it with nullptr
+ * first.
+ *
+ * @tparam R(Args...) The call signature
+ * @tparam Capacity Size of the buffer for the callable in bytes
+ * @tparam Alignment Alignment of the buffer
+ */
+template <typename R, typename... Args, std::size_t Capacity,
+          std::size_t Alignment>
+class inplace_function<R(Args...), Capacity, Alignment> {
+ public:
+  inplace_function() noexcept = default;
+  inplace_function(std::nullptr_t) noexcept {}
+
+  template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, inplace_function> &&
+             std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+  inplace_function(F&& fn) {
+    using stored = std::decay_t<F>;
+    static_assert(sizeof(stored) <= Capacity,
+                  "The callable does not fit into the inplace_function; "
+                  "increase its Capacity or capture less");
+    static_assert(Alignment % alignof(stored) == 0,
+                  "The callable needs a stricter alignment than the "
+                  "inplace_function provides");
+    static_assert(std::is_nothrow_move_constructible_v<stored>,
+                  "inplace_function can only hold callables that move "
+                  "without throwing");
+
+    if constexpr (std::is_pointer_v<stored> ||
+                  std::is_member_pointer_v<stored>) {
+      if (fn == nullptr) {
+        return;
+      }
+    }
+
+    ::new (static_cast<void*>(storage_)) stored(std::forward<F>(fn));
+    invoke_ = [](void* target, Args... args) -> R {
+      return std::invoke(*static_cast<stored*>(target),
+                         std::forward<Args>(args)...);
+    };
+    if constexpr (!std::is_trivially_copyable_v<stored>) {
+      manage_ = &manage<stored>;
+    }
+  }
+
+  inplace_function(inplace_function&& other) noexcept { take(other); }
+
+  inplace_function& operator=(inplace_function&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  inplace_function& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  inplace_function(const inplace_function&) = delete;
+  inplace_function& operator=(const inplace_function&) = delete;
+
+  ~inplace_function() { reset(); }
+
+  R operator()(Args... args) const {
+    return invoke_(storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+  friend bool operator==(const inplace_function& fn, std::nullptr_t) noexcept {
+    return fn.invoke_ == nullptr;
+  }
+
+ private:
+  enum class operation { move, destroy };
+
+  using invoke_type = R (*)(void*, Args...);
+  using manage_type = void (*)(operation, void*, void*) noexcept;
+
+  template <typename T>
+  static void manage(operation op, void* target, void* source) noexcept {
+    if (op == operation::move) {
+      ::new (target) T(std::move(*static_cast<T*>(source)));
+    }
+    std::destroy_at(static_cast<T*>(source));
+  }
+
+  /// Moves the callable of other into this empty object and empties other
+  void take(inplace_function& other) noexcept {
+    if (other.invoke_ == nullptr) {
+      return;
+    }
+    if (other.manage_ != nullptr) {
+      other.manage_(operation::move, storage_, other.storage_);
+    } else {
+      std::memcpy(storage_, other.storage_, Capacity);
+    }
+    invoke_ = std::exchange(other.invoke_, nullptr);
+    manage_ = std::exchange(other.manage_, nullptr);
+  }
+
+  void reset() noexcept {
+    if (manage_ != nullptr) {
+      manage_(operation::destroy, nullptr, storage_);
+    }
+    invoke_ = nullptr;
+    manage_ = nullptr;
+  }
+
+  // Mutable like the target of std::function: calling through a const
+  // wrapper may change the state of the callable
+  alignas(Alignment) mutable std::byte storage_[Capacity];
+  invoke_type invoke_{nullptr};
+  manage_type manage_{nullptr};
+};
+
+template <typename Signature>
+class function_ref;
+
+/**
+ * @brief A non-owning reference to a callable
+ *
+ * Two pointers, the callable and a thunk, and no allocation, for parameters
+ * that only call a callback before returning. The callable must outlive the
+ * function_ref, so it should not be stored.
+ */
+template <typename R, typename... Args>
+class function_ref<R(Args...)> {
+ public:
+  template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, function_ref> &&
+             std::is_invocable_r_v<R, F&, Args...>)
+  function_ref(F&& fn) noexcept {
+    using target = std::remove_reference_t<F>;
+    if constexpr (std::is_function_v<target>) {
+      target_.function = reinterpret_cast<void (*)()>(&fn);
+      invoke_ = [](storage stored, Args... args) -> R {
+        return std::invoke(reinterpret_cast<target*>(stored.function),
+                           std::forward<Args>(args)...);
+      };
+    } else {
+      target_.object = const_cast<void*>(
+          static_cast<const void*>(std::addressof(fn)));
+      invoke_ = [](storage stored, Args... args) -> R {
+        return std::invoke(*static_cast<target*>(stored.object),
+                           std::forward<Args>(args)...);
+      };
+    }
+  }
+
+  R operator()(Args... args) const {
+    return invoke_(target_, std::forward<Args>(args)...);
+  }
+
+ private:
+  union storage {
+    void* object;
+    void (*function)();
+  };
+
+  storage target_{};
+  R (*invoke_)(storage, Args...){nullptr};
+};
+
+}  // namespace malib
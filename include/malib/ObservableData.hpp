@@ -2,16 +2,25 @@
 
 #include <array>
 #include <concepts>
-#include <functional>
 #include <iostream>
 #include <mutex>
-#include <optional>
+#include <utility>
+
+#include "malib/InplaceFunction.hpp"
 
 namespace malib {
 
-template <std::copyable T, std::size_t MaxSubscribers>
+/**
+ * @tparam T Type of the data
+ * @tparam MaxSubscribers Number of callbacks that can subscribe
+ * @tparam CallbackSize Bytes each callback may capture; callbacks are stored
+ * in place, so subscribing never allocates
+ */
+template <std::copyable T, std::size_t MaxSubscribers,
+          std::size_t CallbackSize = 32>
 struct ObservableData {
-  using NotificationCallback = std::function<void(ObservableData&)>;
+  using NotificationCallback =
+      inplace_function<void(ObservableData&), CallbackSize>;
 
   /**
    * @brief Updates the stored data with new data and notifies observers
@@ -44,26 +53,23 @@ struct ObservableData {
    */
   void subscribe(NotificationCallback callback) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (subscriber_idx_ >= MaxSubscribers) {
+    if (subscriber_idx_ >= MaxSubscribers || callback == nullptr) {
       return;
     }
-    subscribers_[subscriber_idx_] = callback;
+    subscribers_[subscriber_idx_] = std::move(callback);
     subscriber_idx_++;
   }
 
  private:
   void notify() {
-    for (const auto& subscriber : subscribers_) {
-      if (subscriber.has_value()) {
-        subscriber.value()(*this);
-      }
+    for (std::size_t i = 0; i < subscriber_idx_; ++i) {
+      subscribers_[i](*this);
     }
   }
 
  private:
   T data_{};
-  std::array<std::optional<NotificationCallback>, MaxSubscribers>
-      subscribers_{};
+  std::array<NotificationCallback, MaxSubscribers> subscribers_{};
   std::mutex mutex_{};
   std::size_t subscriber_idx_{0};
 };
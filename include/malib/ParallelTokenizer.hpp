@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "malib/CharClasses.hpp"
+#include "malib/Error.hpp"
+#include "malib/Token.hpp"
+#include "malib/Tokenizer.hpp"
+
+namespace malib {
+
+/**
+ * @brief Tokenizes large multi-line inputs on several threads
+ *
+ * The input is cut into chunks of roughly chunk_size bytes, each ending right
+ * after a newline. Tokenizing the chunks on their own gives the same tokens as
+ * tokenizing the whole input, as long as no cut lies inside quotes. That is
+ * checked in a first parallel pass that finds the number of unescaped quote
+ * characters in every chunk: a chunk that starts inside quotes is merged into
+ * the one before it. A second parallel pass tokenizes every chunk with
+ * Tokenizer::scan into its own token array.
+ *
+ * Token offsets are relative to the start of their chunk, so chunk_size
+ * should stay below TokenType::max_offset.
+ *
+ * @tparam Classes Character classes, see CharClasses.hpp; '\n' must be a
+ * separator
+ * @tparam TokenType The token representation, see BasicToken
+ */
+template <CharClassTable Classes = char_classes::shell,
+          typename TokenType = Token>
+class ParallelTokenizer {
+  static_assert(Classes.is('\n', CharClass::Separator),
+                "Chunks are split at newlines, which must separate tokens");
+
+ public:
+  /**
+   * @brief The tokens of one chunk of the input
+   */
+  struct Chunk {
+    std::string_view input{};
+    std::vector<TokenType> tokens{};
+
+    /**
+     * @brief Returns the tokens as views into the chunk
+     */
+    BasicTokenViews<TokenType> views() const noexcept {
+      // Tokens come from the Tokenizer and are always valid for input
+      return *BasicTokenViews<TokenType>::create(input, tokens);
+    }
+  };
+
+  /**
+   * @param threads Number of threads to use, including the calling thread
+   * @param chunk_size Target number of bytes per chunk
+   */
+  explicit ParallelTokenizer(
+      std::size_t threads = std::thread::hardware_concurrency(),
+      std::size_t chunk_size = DefaultChunkSize) noexcept
+      : threads_(std::max<std::size_t>(threads, 1)),
+        chunk_size_(std::max<std::size_t>(chunk_size, 1)) {}
+
+  /**
+   * @brief Tokenizes the input, replacing the result of the previous call
+   *
+   * The input must outlive the chunks.
+   *
+   * @return The total number of tokens, or the first error reported for any
+   * chunk, such as Error::ResultOutOfRange if a token does not fit TokenType
+   */
+  std::expected<std::size_t, Error> tokenize(std::string_view input) {
+    split(input);
+
+    std::vector<std::uint8_t> parity(chunks_.size());
+    parallel_for(chunks_.size(), [&](std::size_t i) {
+      parity[i] = quote_parity(chunks_[i].input);
+    });
+    merge_quoted(parity);
+
+    std::vector<Error> errors(chunks_.size(), Error::Ok);
+    parallel_for(chunks_.size(), [&](std::size_t i) {
+      auto& chunk = chunks_[i];
+      chunk.tokens.clear();
+      errors[i] = scanner::scan(chunk.input, [&](std::size_t offset,
+                                                 std::size_t length) {
+        if (!TokenType::fits(offset, length)) {
+          return Error::ResultOutOfRange;
+        }
+        TokenType token{};
+        token.offset = offset;
+        token.length = length;
+        chunk.tokens.push_back(token);
+        return Error::Ok;
+      });
+    });
+
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < chunks_.size(); ++i) {
+      if (errors[i] != Error::Ok) {
+        return std::unexpected(errors[i]);
+      }
+      total += chunks_[i].tokens.size();
+    }
+    return total;
+  }
+
+  /**
+   * @brief Returns the chunks of the last input, in input order
+   */
+  [[nodiscard]] std::span<const Chunk> chunks() const noexcept {
+    return chunks_;
+  }
+
+  [[nodiscard]] std::size_t threads() const noexcept { return threads_; }
+
+ private:
+  static constexpr std::size_t DefaultChunkSize = std::size_t{1} << 20;
+  static constexpr auto Quote = static_cast<std::uint8_t>(CharClass::Quote);
+  static constexpr auto Escape = static_cast<std::uint8_t>(CharClass::Escape);
+  static constexpr bool HasEscapes =
+      Classes.members(CharClass::Escape).size > 0;
+
+  // Only the static scan is used, so the token capacity does not matter
+  using scanner = Tokenizer<1, Classes, TokenType>;
+
+  /**
+   * @brief Cuts the input into chunks that end after an unescaped newline
+   */
+  void split(std::string_view input) {
+    chunks_.clear();
+    std::size_t start = 0;
+    while (start < input.size()) {
+      auto end = std::min(start + chunk_size_, input.size());
+      while (end < input.size()) {
+        end = input.find('\n', end);
+        if (end == std::string_view::npos) {
+          end = input.size();
+          break;
+        }
+        end++;
+        if (!escaped(input, end - 1)) {
+          break;
+        }
+      }
+
+      chunks_.push_back(Chunk{input.substr(start, end - start), {}});
+      start = end;
+    }
+  }
+
+  /**
+   * @brief Checks whether the character at pos follows an odd run of escapes
+   */
+  static bool escaped(std::string_view input, std::size_t pos) noexcept {
+    if constexpr (HasEscapes) {
+      std::size_t run = 0;
+      while (pos > run && (Classes[input[pos - run - 1]] & Escape)) {
+        run++;
+      }
+      return run % 2 == 1;
+    } else {
+      return false;
+    }
+  }
+
+  /**
+   * @brief Returns 1 if the chunk has an odd number of unescaped quotes
+   */
+  static std::uint8_t quote_parity(std::string_view input) noexcept {
+    std::uint8_t parity = 0;
+    bool escaped = false;
+    for (char c : input) {
+      const auto cls = Classes[c];
+      if constexpr (HasEscapes) {
+        if (escaped) {
+          escaped = false;
+          continue;
+        }
+        if (cls & Escape) {
+          escaped = true;
+          continue;
+        }
+      }
+      parity ^= (cls & Quote) ? 1 : 0;
+    }
+    return parity;
+  }
+
+  /**
+   * @brief Merges every chunk that starts inside quotes into the one before
+   */
+  void merge_quoted(const std::vector<std::uint8_t>& parity) {
+    std::size_t out = 0;
+    bool inside = false;
+    for (std::size_t i = 0; i < chunks_.size(); ++i) {
+      if (inside) {
+        auto& last = chunks_[out - 1].input;
+        last = std::string_view(last.data(),
+                                last.size() + chunks_[i].input.size());
+      } else {
+        chunks_[out++].input = chunks_[i].input;
+      }
+      inside ^= parity[i] != 0;
+    }
+    chunks_.resize(out);
+  }
+
+  /**
+   * @brief Runs fn(i) for every i below count on up to threads_ threads
+   */
+  template <typename Fn>
+  void parallel_for(std::size_t count, Fn&& fn) {
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+      for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+           i = next.fetch_add(1, std::memory_order_relaxed)) {
+        fn(i);
+      }
+    };
+
+    std::vector<std::thread> workers{};
+    const auto helpers = std::min(threads_, count) - (count > 0 ? 1 : 0);
+    workers.reserve(helpers);
+    for (std::size_t i = 0; i < helpers; ++i) {
+      workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  std::size_t threads_;
+  std::size_t chunk_size_;
+  std::vector<Chunk> chunks_{};
+};
+
+}  // namespace malib
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string_view>
+
+#include "malib/Error.hpp"
+
+namespace malib {
+
+namespace perfect_hash_detail {
+constexpr std::uint64_t hash(std::string_view key,
+                             std::uint64_t seed) noexcept {
+  std::uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+  for (char c : key) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 0x100000001b3ULL;
+  }
+  return h ^ (h >> 29);
+}
+}  // namespace perfect_hash_detail
+
+/**
+ * @brief A string lookup table without collisions, built at compile time
+ *
+ * The constructor searches for a hash seed that puts every key in its own
+ * slot of a power-of-two table at least twice as large as the key count, so a
+ * lookup is one hash and one string compare. Keys are not copied; they must
+ * outlive the table, which string literals do.
+ *
+ * @tparam KeyCount Number of keys; empty keys are skipped, so callers can
+ * leave out entries without changing their indices
+ */
+template <std::size_t KeyCount>
+class PerfectHash {
+  static_assert(KeyCount > 0);
+
+ public:
+  consteval explicit PerfectHash(
+      const std::array<std::string_view, KeyCount>& keys) {
+    for (std::size_t i = 0; i < KeyCount; ++i) {
+      for (std::size_t j = 0; j < i; ++j) {
+        if (!keys[i].empty() && keys[i] == keys[j]) {
+          detail::consteval_error("Duplicate key");
+        }
+      }
+    }
+
+    for (std::uint64_t seed = 0;; ++seed) {
+      std::array<slot, TableSize> table{};
+      bool collision = false;
+      for (std::size_t i = 0; i < KeyCount && !collision; ++i) {
+        if (keys[i].empty()) {
+          continue;
+        }
+        auto& entry = table[index_of(keys[i], seed)];
+        collision = entry.used;
+        entry = slot{keys[i], i, true};
+      }
+
+      if (!collision) {
+        table_ = table;
+        seed_ = seed;
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the index of key in the array the table was built from
+   * @return The index, or Error::InvalidArgument if key is not in the table
+   */
+  constexpr std::expected<std::size_t, Error> find(
+      std::string_view key) const noexcept {
+    const auto& entry = table_[index_of(key, seed_)];
+    if (entry.used && entry.key == key) {
+      return entry.index;
+    }
+    return std::unexpected(Error::InvalidArgument);
+  }
+
+  [[nodiscard]] static constexpr std::size_t table_size() noexcept {
+    return TableSize;
+  }
+
+ private:
+  static constexpr std::size_t TableSize = std::bit_ceil(KeyCount * 2);
+
+  struct slot {
+    std::string_view key{};
+    std::size_t index{0};
+    bool used{false};
+  };
+
+  static constexpr std::size_t index_of(std::string_view key,
+                                        std::uint64_t seed) noexcept {
+    return static_cast<std::size_t>(perfect_hash_detail::hash(key, seed) &
+                                    (TableSize - 1));
+  }
+
+  std::array<slot, TableSize> table_{};
+  std::uint64_t seed_{0};
+};
+
+}  // namespace malib
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string_view>
+#include <vector>
+
+#include "malib/Error.hpp"
+
+namespace malib {
+
+/**
+ * @brief A radix tree over strings for exact, prefix and completion lookups
+ *
+ * Keys are copied into one character arena and nodes live in one array, so
+ * the tree is two allocations that grow geometrically and copy as plain
+ * vectors. Edge labels are slices of the keys in the arena, which means a
+ * split never copies characters. Children are kept sorted by their first
+ * character, and every node counts the keys below it, so:
+ * - find() matches a key exactly,
+ * - resolve() accepts any prefix that identifies a single key,
+ * - complete() lists the keys under a prefix in lexicographic order,
+ * each walking the tree once along the input.
+ *
+ * Views returned by resolve() and complete() point into the arena and stay
+ * valid until the next insert().
+ */
+class PrefixIndex {
+ public:
+  using value_type = std::uint32_t;
+
+  struct match {
+    std::string_view key;
+    value_type value;
+  };
+
+  PrefixIndex() { nodes_.emplace_back(); }
+
+  /**
+   * @brief Adds a key or replaces the value of an existing one
+   * @return Error::Ok, or Error::EmptyInput for an empty key
+   */
+  Error insert(std::string_view key, value_type value) {
+    if (key.empty()) {
+      return Error::EmptyInput;
+    }
+
+    auto existing = locate(key);
+    if (existing.node != NoNode && existing.exact &&
+        nodes_[existing.node].terminal) {
+      nodes_[existing.node].value = value;
+      return Error::Ok;
+    }
+
+    const auto key_offset = static_cast<std::uint32_t>(chars_.size());
+    chars_.insert(chars_.end(), key.begin(), key.end());
+
+    std::uint32_t current = 0;
+    std::size_t pos = 0;
+    nodes_[current].keys++;
+    while (pos < key.size()) {
+      // Find the child starting with key[pos], or where it would go
+      std::uint32_t previous = NoNode;
+      std::uint32_t child = nodes_[current].first_child;
+      const auto next = static_cast<unsigned char>(key[pos]);
+      while (child != NoNode && first_char(child) < next) {
+        previous = child;
+        child = nodes_[child].next_sibling;
+      }
+
+      if (child == NoNode || first_char(child) != next) {
+        node leaf{};
+        leaf.label_offset = key_offset + static_cast<std::uint32_t>(pos);
+        leaf.label_length = static_cast<std::uint32_t>(key.size() - pos);
+        leaf.next_sibling = child;
+        leaf.keys = 1;
+        current = append(leaf, current, previous);
+        pos = key.size();
+        break;
+      }
+
+      const auto label = label_of(child);
+      const auto rest = key.substr(pos);
+      const auto common = static_cast<std::uint32_t>(
+          std::mismatch(label.begin(), label.end(), rest.begin(), rest.end())
+              .first -
+          label.begin());
+
+      if (common < label.size()) {
+        // Split the edge: a new node takes the common part
+        node middle{};
+        middle.label_offset = nodes_[child].label_offset;
+        middle.label_length = common;
+        middle.first_child = child;
+        middle.next_sibling = nodes_[child].next_sibling;
+        middle.keys = nodes_[child].keys;
+        nodes_[child].label_offset += common;
+        nodes_[child].label_length -= common;
+        nodes_[child].next_sibling = NoNode;
+        child = append(middle, current, previous);
+      }
+
+      nodes_[child].keys++;
+      current = child;
+      pos += common;
+    }
+
+    auto& terminal = nodes_[current];
+    terminal.terminal = true;
+    terminal.key_offset = key_offset;
+    terminal.key_length = static_cast<std::uint32_t>(key.size());
+    terminal.value = value;
+    size_++;
+    return Error::Ok;
+  }
+
+  /**
+   * @brief Returns the value of a key, or Error::InvalidArgument
+   */
+  std::expected<value_type, Error> find(std::string_view key) const noexcept {
+    auto found = locate(key);
+    if (found.node == NoNode || !found.exact || !nodes_[found.node].terminal) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    return nodes_[found.node].value;
+  }
+
+  /**
+   * @brief Resolves a key or an abbreviation of exactly one key
+   *
+   * An exact key wins over longer keys it is a prefix of.
+   *
+   * @return The key and its value, Error::InvalidArgument if no key starts
+   * with prefix, or Error::MaximumSizeExceeded if several keys do
+   */
+  std::expected<match, Error> resolve(std::string_view prefix) const noexcept {
+    auto found = locate(prefix);
+    if (found.node == NoNode || prefix.empty()) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+
+    auto current = found.node;
+    if (!(found.exact && nodes_[current].terminal)) {
+      if (nodes_[current].keys != 1) {
+        return std::unexpected(Error::MaximumSizeExceeded);
+      }
+      while (!nodes_[current].terminal) {
+        current = nodes_[current].first_child;
+      }
+    }
+    return match{key_of(current), nodes_[current].value};
+  }
+
+  /**
+   * @brief Calls fn(key, value) for every key starting with prefix, in
+   * lexicographic order
+   * @return The number of keys visited
+   */
+  template <typename Fn>
+  std::size_t complete(std::string_view prefix, Fn&& fn) const {
+    auto found = locate(prefix);
+    if (found.node == NoNode) {
+      return 0;
+    }
+    visit(found.node, fn);
+    return nodes_[found.node].keys;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+ private:
+  static constexpr std::uint32_t NoNode = ~std::uint32_t{0};
+
+  struct node {
+    std::uint32_t label_offset{0};
+    std::uint32_t label_length{0};
+    std::uint32_t key_offset{0};
+    std::uint32_t key_length{0};
+    std::uint32_t first_child{NoNode};
+    std::uint32_t next_sibling{NoNode};
+    std::uint32_t keys{0};  // number of keys in this subtree
+    value_type value{0};
+    bool terminal{false};
+  };
+
+  struct location {
+    std::uint32_t node;
+    bool exact;  // the input ends at the node, not inside its label
+  };
+
+  unsigned char first_char(std::uint32_t index) const noexcept {
+    return static_cast<unsigned char>(chars_[nodes_[index].label_offset]);
+  }
+
+  std::string_view label_of(std::uint32_t index) const noexcept {
+    return {chars_.data() + nodes_[index].label_offset,
+            nodes_[index].label_length};
+  }
+
+  std::string_view key_of(std::uint32_t index) const noexcept {
+    return {chars_.data() + nodes_[index].key_offset,
+            nodes_[index].key_length};
+  }
+
+  /**
+   * @brief Adds a node to the arena and links it after previous, or as the
+   * first child of parent
+   */
+  std::uint32_t append(const node& added, std::uint32_t parent,
+                       std::uint32_t previous) {
+    const auto index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(added);
+    if (previous == NoNode) {
+      nodes_[parent].first_child = index;
+    } else {
+      nodes_[previous].next_sibling = index;
+    }
+    return index;
+  }
+
+  /**
+   * @brief Finds the node whose path covers the input
+   */
+  location locate(std::string_view input) const noexcept {
+    std::uint32_t current = 0;
+    while (!input.empty()) {
+      const auto next = static_cast<unsigned char>(input.front());
+      auto child = nodes_[current].first_child;
+      while (child != NoNode && first_char(child) < next) {
+        child = nodes_[child].next_sibling;
+      }
+      if (child == NoNode || first_char(child) != next) {
+        return {NoNode, false};
+      }
+
+      const auto label = label_of(child);
+      if (input.size() < label.size()) {
+        return {label.starts_with(input) ? child : NoNode, false};
+      }
+      if (!input.starts_with(label)) {
+        return {NoNode, false};
+      }
+      input.remove_prefix(label.size());
+      current = child;
+    }
+    return {current, true};
+  }
+
+  template <typename Fn>
+  void visit(std::uint32_t index, Fn& fn) const {
+    if (nodes_[index].terminal) {
+      fn(key_of(index), nodes_[index].value);
+    }
+    for (auto child = nodes_[index].first_child; child != NoNode;
+         child = nodes_[child].next_sibling) {
+      visit(child, fn);
+    }
+  }
+
+  std::vector<node> nodes_{};
+  std::vector<char> chars_{};
+  std::size_t size_{0};
+};
+
+}  // namespace malib
@@ -1,15 +1,27 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <expected>
-#include <functional>
-#include <map>
+#include <memory>
 #include <mutex>
 #include <span>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "malib/FixedLengthLinearBuffer.hpp"
 #include "malib/FixedStringBuffer.hpp"
+#include "malib/InplaceFunction.hpp"
+#include "malib/PrefixIndex.hpp"
+#include "malib/ShellBinding.hpp"
+#include "malib/ShellCache.hpp"
+#include "malib/ShellStats.hpp"
 #include "malib/Token.hpp"
+#include "malib/TokenRange.hpp"
 #include "malib/Tokenizer.hpp"
 #include "malib/concepts.hpp"
 
@@ -20,21 +32,557 @@ using arguments = TokenViews;
 
 static constexpr auto ShellFixedLengthLinearBufferSize = 256;
 static constexpr auto ShellMaxTokensLength = 32;
+static constexpr auto ShellCallbackSize = 64;
 
+namespace detail {
+inline constexpr std::string_view invalid_command_message = "Invalid command\n";
+inline constexpr std::string_view ambiguous_command_message =
+    "Ambiguous command\n";
+inline constexpr std::string_view no_command_message =
+    "Command has no executable code\n";
+
+/**
+ * @brief Tokenizes a command line and returns the tokens after the command
+ */
+template <std::size_t MaxTokens>
+std::expected<arguments, Error> tokenize_arguments(
+    Tokenizer<MaxTokens>& tokenizer, std::string_view input) {
+  auto tokenizer_result = tokenizer.tokenize(input);
+  if (!tokenizer_result.has_value()) {
+    return std::unexpected(tokenizer_result.error());
+  }
+  return TokenViews::create(input, tokenizer.tokens_span().subspan(1));
+}
+
+/**
+ * @brief Copies the command output from a shell buffer to the caller
+ *
+ * Segmented buffers such as ChainedBuffer are written one segment at a time
+ * and released right away, so their memory is only held while a command
+ * runs.
+ */
+template <typename OutputBufferType>
+Error flush_output(OutputBufferType& buffer, output_interface auto& output) {
+  if constexpr (requires { buffer.write_to(output); }) {
+    auto result = buffer.write_to(output);
+    buffer.clear();
+    return result.error_or(Error::Ok);
+  } else {
+    return output.write(buffer.data(), buffer.size()).error_or(Error::Ok);
+  }
+}
+/**
+ * @brief An output that appends to a string, used to capture command output
+ */
+struct string_sink {
+  std::string& text;
+
+  std::expected<std::size_t, Error> write(const char* data, std::size_t size) {
+    text.append(data, size);
+    return size;
+  }
+
+  std::expected<std::size_t, Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+
+/**
+ * @brief An output that also appends everything the wrapped output accepted
+ * to a string
+ *
+ * complete turns false once the wrapped output fails or takes only part of a
+ * write, since the copy then no longer matches what it received.
+ */
+template <typename Output>
+struct tee_output {
+  Output& output;
+  std::string& copy;
+  bool complete{true};
+
+  auto write(const char* data, std::size_t size) {
+    auto result = output.write(data, size);
+    std::size_t accepted = 0;
+    if constexpr (std_expected_any_error<decltype(result), std::size_t>) {
+      accepted = result.value_or(0);
+      complete = complete && result.has_value();
+    } else {
+      accepted = static_cast<std::size_t>(result);
+    }
+    accepted = std::min(accepted, size);
+    complete = complete && accepted == size;
+    copy.append(data, accepted);
+    return result;
+  }
+
+  std::expected<std::size_t, Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+}  // namespace detail
+
+/**
+ * @brief What a script does when one of its lines fails
+ */
+enum class on_error : std::uint8_t {
+  stop,    ///< Skip the remaining lines
+  resume,  ///< Run the remaining lines and report the first error
+};
+
+/**
+ * @brief A command output buffer that streams to the caller's output
+ *
+ * Using it as the OutputBufferType of a shell switches the shell to
+ * streaming mode: instead of collecting the whole command output and copying
+ * it once the callback returns, every write is forwarded to the output that
+ * was passed to execute() while the command runs, so output size is not
+ * limited by a buffer and the first bytes leave right away.
+ *
+ * Writes smaller than CoalesceSize are gathered in a fixed buffer and
+ * forwarded together once it fills, when the command returns, or on flush().
+ * With CoalesceSize 0 every write is forwarded on its own.
+ *
+ * The output applies backpressure by accepting fewer bytes than offered or by
+ * returning Error::BufferFull. The writer then waits and offers the rest
+ * again, which blocks the command until the output catches up. An output
+ * with a `bool wait_writable(std::chrono::nanoseconds)` member, e.g. one that
+ * polls a socket, is asked to wait; otherwise the writer sleeps with an
+ * exponential backoff. Once StallTimeoutMs pass without progress the write
+ * fails with Error::BufferFull, so commands do not hang on a dead output.
+ * Other output errors are returned to the command immediately.
+ *
+ * @tparam CoalesceSize Size of the coalescing buffer in bytes, may be 0
+ * @tparam StallTimeoutMs Milliseconds without progress before giving up
+ */
+template <std::size_t CoalesceSize = 0, std::size_t StallTimeoutMs = 1000>
+class stream_writer {
+ public:
+  stream_writer() noexcept = default;
+  stream_writer(const stream_writer&) = delete;
+  stream_writer& operator=(const stream_writer&) = delete;
+
+  std::expected<std::size_t, Error> write(const char* data, std::size_t size) {
+    if (data == nullptr) {
+      return std::unexpected(Error::NullPointerInput);
+    }
+    if (target_ == nullptr) {
+      return std::unexpected(Error::NullPointerOutput);
+    }
+
+    if (pending_ + size <= CoalesceSize) {
+      std::copy_n(data, size, buffer_.begin() + pending_);
+      pending_ += size;
+      return size;
+    }
+
+    auto result = flush();
+    if (result != Error::Ok) {
+      return std::unexpected(result);
+    }
+    if (size < CoalesceSize) {
+      std::copy_n(data, size, buffer_.begin());
+      pending_ = size;
+      return size;
+    }
+
+    result = forward(data, size);
+    if (result != Error::Ok) {
+      return std::unexpected(result);
+    }
+    return size;
+  }
+
+  std::expected<std::size_t, Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+
+  /**
+   * @brief Forwards the coalesced bytes to the output
+   */
+  Error flush() {
+    if (pending_ == 0) {
+      return Error::Ok;
+    }
+    if (target_ == nullptr) {
+      return Error::NullPointerOutput;
+    }
+    const auto size = pending_;
+    pending_ = 0;
+    return forward(buffer_.data(), size);
+  }
+
+  /**
+   * @brief Drops coalesced bytes that were not forwarded yet
+   */
+  void clear() noexcept { pending_ = 0; }
+
+  /**
+   * @brief Returns the number of bytes the output accepted so far
+   */
+  [[nodiscard]] std::size_t forwarded() const noexcept { return forwarded_; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return pending_; }
+
+  /**
+   * @brief Forwards all writes to output until detach() is called
+   */
+  template <output_interface Output>
+  void attach(Output& output) noexcept {
+    target_ = &output;
+    sink_ = [](void* target, const char* data,
+               std::size_t size) -> std::expected<std::size_t, Error> {
+      auto& out = *static_cast<Output*>(target);
+      if constexpr (std_expected_any_error<decltype(out.write(data, size)),
+                                           std::size_t>) {
+        auto result = out.write(data, size);
+        if (!result.has_value()) {
+          return std::unexpected(result.error());
+        }
+        return *result;
+      } else {
+        return static_cast<std::size_t>(out.write(data, size));
+      }
+    };
+    if constexpr (requires(Output& out, std::chrono::nanoseconds timeout) {
+                    { out.wait_writable(timeout) } -> std::convertible_to<bool>;
+                  }) {
+      waiter_ = [](void* target, std::chrono::nanoseconds timeout) {
+        static_cast<Output*>(target)->wait_writable(timeout);
+      };
+    } else {
+      waiter_ = nullptr;
+    }
+    pending_ = 0;
+    forwarded_ = 0;
+  }
+
+  void detach() noexcept {
+    target_ = nullptr;
+    sink_ = nullptr;
+    waiter_ = nullptr;
+    pending_ = 0;
+  }
+
+ private:
+  static constexpr std::chrono::microseconds FirstBackoff{10};
+  static constexpr std::chrono::microseconds MaxBackoff{2000};
+
+  Error forward(const char* data, std::size_t size) {
+    using clock = std::chrono::steady_clock;
+    clock::time_point deadline{};
+    std::chrono::microseconds backoff{0};
+    while (size > 0) {
+      auto result = sink_(target_, data, size);
+      if (!result.has_value() && result.error() != Error::BufferFull) {
+        return result.error();
+      }
+
+      const std::size_t accepted =
+          result.has_value() ? std::min(*result, size) : 0;
+      if (accepted == 0) {
+        const auto now = clock::now();
+        if (backoff.count() == 0) {
+          deadline = now + std::chrono::milliseconds{StallTimeoutMs};
+          backoff = FirstBackoff;
+        } else if (now >= deadline) {
+          return Error::BufferFull;
+        }
+        const auto remaining =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(deadline -
+                                                                 now);
+        if (waiter_ != nullptr) {
+          waiter_(target_, remaining);
+        } else {
+          std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+              backoff, remaining));
+          backoff = std::min(backoff * 2, MaxBackoff);
+        }
+        continue;
+      }
+
+      backoff = std::chrono::microseconds{0};
+      data += accepted;
+      size -= accepted;
+      forwarded_ += accepted;
+    }
+    return Error::Ok;
+  }
+
+  using sink_type = std::expected<std::size_t, Error> (*)(void*, const char*,
+                                                          std::size_t);
+  using waiter_type = void (*)(void*, std::chrono::nanoseconds);
+
+  void* target_{nullptr};
+  sink_type sink_{nullptr};
+  waiter_type waiter_{nullptr};
+  std::size_t pending_{0};
+  std::size_t forwarded_{0};
+  std::array<char, CoalesceSize> buffer_{};
+};
+
+/**
+ * @brief The per-caller state of a shell: tokenizer and output buffer
+ *
+ * A shell executes commands for any number of sessions in parallel, as long
+ * as every session is used by one thread at a time.
+ */
 template <output_interface OutputBufferType =
               FixedLengthLinearBuffer<char, ShellFixedLengthLinearBufferSize>,
           std::size_t MaxTokens = ShellMaxTokensLength>
+class session {
+ public:
+  using output_buffer_type = OutputBufferType;
+
+  /**
+   * @brief Tokenizes input, runs fn(command, args, buffer) and writes the
+   * buffered output to output, even if fn fails
+   *
+   * @return The tokenizer error, the error of fn, or the output error
+   */
+  template <typename Fn>
+  Error run(Fn&& fn, std::string_view command, std::string_view input,
+            output_interface auto& output) {
+    auto args = detail::tokenize_arguments(tokenizer_, input);
+    if (!args.has_value()) {
+      return args.error();
+    }
+    return call(fn, command, *args, output);
+  }
+
+  /**
+   * @brief Runs fn(command, args, buffer) on arguments that are already
+   * split and writes the buffered output to output, even if fn fails
+   */
+  template <typename Fn>
+  Error call(Fn&& fn, std::string_view command, arguments args,
+             output_interface auto& output) {
+    if constexpr (requires { output_buffer_.attach(output); }) {
+      // Streaming: the command writes through to output as it runs
+      output_buffer_.attach(output);
+      auto command_result = fn(command, args, output_buffer_);
+      auto flush_result = output_buffer_.flush();
+      output_buffer_.detach();
+      return command_result != Error::Ok ? command_result : flush_result;
+    } else {
+      output_buffer_.clear();
+      auto command_result = fn(command, args, output_buffer_);
+      if (command_result != Error::Ok) {
+        detail::flush_output(output_buffer_, output);
+        return command_result;
+      }
+
+      return detail::flush_output(output_buffer_, output);
+    }
+  }
+
+  /**
+   * @brief Runs fn like run(), unless cache holds output for the same
+   * command name and argument tokens, which is then written to output
+   * without calling fn
+   *
+   * Output of calls that return Error::Ok is stored in cache for ttl, if
+   * output accepted all of it and the cache was not invalidated since
+   * generation was read.
+   *
+   * @param name The name of the command as registered, so abbreviations
+   * share entries with the full name
+   * @param generation response_cache::generation() read before the command
+   * was looked up
+   */
+  template <typename Fn>
+  Error run_cached(Fn&& fn, std::string_view command, std::string_view input,
+                   output_interface auto& output, response_cache& cache,
+                   std::string_view name, std::chrono::nanoseconds ttl,
+                   std::uint64_t generation) {
+    auto args = detail::tokenize_arguments(tokenizer_, input);
+    if (!args.has_value()) {
+      return args.error();
+    }
+
+    cache_key_.assign(name);
+    for (auto arg : *args) {
+      cache_key_.push_back('\0');
+      cache_key_.append(arg);
+    }
+    if (auto cached = cache.find(cache_key_); cached != nullptr) {
+      return output.write(cached->data(), cached->size())
+          .error_or(Error::Ok);
+    }
+
+    cache_output_.clear();
+    detail::tee_output<std::remove_reference_t<decltype(output)>> tee{
+        output, cache_output_};
+    auto result = call(fn, command, *args, tee);
+    if (result == Error::Ok && tee.complete) {
+      cache.store(cache_key_, cache_output_, ttl, generation);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Runs a script of command lines and pipelines
+   *
+   * Lines are separated by '\n'; blank lines and lines starting with '#' are
+   * skipped. A line may be a pipeline "cmd1 args | cmd2 args": the output of
+   * each stage is appended to the next stage's line and tokenized with it,
+   * so it arrives as extra arguments. Stage output stays in memory, and the
+   * output of the last stage of every line is collected and written to
+   * output in a single write once the script ends or stops.
+   *
+   * The buffers are kept by the session, so running scripts does not
+   * allocate once they have grown to the largest line and output.
+   *
+   * @param execute Runs one command line, as execute(line, sink) -> Error
+   * @return Error::Ok, the first error of a line, or the output error
+   */
+  template <typename Execute>
+  Error run_script(std::string_view script, output_interface auto& output,
+                   on_error policy, Execute&& execute) {
+    script_output_.clear();
+    Error first_error = Error::Ok;
+
+    while (!script.empty()) {
+      const auto end = script.find('\n');
+      auto line = script.substr(0, end);
+      script.remove_prefix(end == std::string_view::npos ? script.size()
+                                                         : end + 1);
+
+      const auto start = line.find_first_not_of(" \t\r");
+      if (start == std::string_view::npos || line[start] == '#') {
+        continue;
+      }
+
+      auto result = run_pipeline(line, execute);
+      if (result != Error::Ok && first_error == Error::Ok) {
+        first_error = result;
+      }
+      if (result != Error::Ok && policy == on_error::stop) {
+        break;
+      }
+    }
+
+    if (!script_output_.empty()) {
+      auto written = output.write(script_output_.data(), script_output_.size())
+                         .error_or(Error::Ok);
+      if (first_error == Error::Ok) {
+        first_error = written;
+      }
+    }
+    return first_error;
+  }
+
+ private:
+  /**
+   * @brief Runs the stages of one line, appending the output of the last
+   * stage, or of the stage that failed, to the script output
+   */
+  template <typename Execute>
+  Error run_pipeline(std::string_view line, Execute& execute) {
+    pipe_.clear();
+    auto stages = TokenRange<char_classes::pipeline>{line};
+    for (auto it = stages.begin(); it != std::default_sentinel;) {
+      const auto stage = *it;
+      ++it;
+
+      // The previous stage's output becomes trailing arguments
+      stage_line_.assign(stage);
+      if (!pipe_.empty()) {
+        stage_line_.push_back(' ');
+        stage_line_.append(pipe_);
+        pipe_.clear();
+      }
+
+      const bool last = it == std::default_sentinel;
+      detail::string_sink sink{last ? script_output_ : pipe_};
+      auto result = execute(std::string_view{stage_line_}, sink);
+      if (result != Error::Ok) {
+        script_output_.append(pipe_);
+        return result;
+      }
+    }
+    return Error::Ok;
+  }
+
+  OutputBufferType output_buffer_{};
+  Tokenizer<MaxTokens> tokenizer_{};
+  std::string stage_line_{};
+  std::string pipe_{};
+  std::string script_output_{};
+  std::string cache_key_{};
+  std::string cache_output_{};
+};
+
+/**
+ * @brief A shell with commands registered at run time
+ *
+ * @tparam OutputBufferType Buffer that collects the output of a command
+ * @tparam MaxTokens Maximum number of tokens of a command line
+ * @tparam CollectStats Keeps a command_stats per command and registers the
+ * built-in stats command; without it no clock is read and nothing is counted
+ */
+template <output_interface OutputBufferType =
+              FixedLengthLinearBuffer<char, ShellFixedLengthLinearBufferSize>,
+          std::size_t MaxTokens = ShellMaxTokensLength,
+          bool CollectStats = false>
 struct tiny {
   using callback =
-      std::function<Error(std::string_view, arguments, OutputBufferType&)>;
-  using registry = std::map<std::string_view, callback>;
+      inplace_function<Error(std::string_view, arguments, OutputBufferType&),
+                       ShellCallbackSize>;
+  using stats_type =
+      std::conditional_t<CollectStats, command_stats, detail::no_stats>;
+  /**
+   * @brief A registered command: its callback and, if enabled, its stats
+   */
+  struct command_entry {
+    std::string name;
+    callback fn;
+    [[no_unique_address]] mutable stats_type stats{};
+    /// Time to keep output in the response cache, in ns; 0 disables it
+    mutable std::atomic<std::int64_t> cache_ttl{0};
+  };
+  /**
+   * @brief An immutable snapshot of the registered commands
+   *
+   * The names are kept in a PrefixIndex whose values index callbacks.
+   */
+  struct registry {
+    PrefixIndex names{};
+    std::vector<std::shared_ptr<const command_entry>> callbacks{};
+  };
+  using session_type = session<OutputBufferType, MaxTokens>;
+
+  /**
+   * @brief Creates a shell without commands, or with only the built-in stats
+   * command if CollectStats is set
+   *
+   * "stats" writes one "name calls=N errors=N bytes=N" line per command;
+   * "stats name" writes the error codes and latency histograms of one
+   * command, see command_stats::write_details.
+   */
+  tiny() {
+    if constexpr (CollectStats) {
+      registerCommand("stats", [this](std::string_view, arguments args,
+                                      OutputBufferType& output) {
+        return writeStats(args, output);
+      });
+    }
+  }
+  ~tiny() { delete node_of(head_.load(std::memory_order_acquire)); }
+  tiny(const tiny&) = delete;
+  tiny& operator=(const tiny&) = delete;
 
   /**
    * @brief Registers a command with the specified name and callback function.
    * 
    * This method allows adding new commands to the shell's command registry.
    * The command name must not be empty and the callback function must be valid.
-   * Thread-safe registration is ensured through mutex protection.
+   * The registry is copied, updated and swapped in, so commands that are
+   * running keep their callback. Lookups count themselves on the snapshot
+   * they read, and the last of them to finish frees it once it has been
+   * replaced, so registration never waits for readers. Replacing a command
+   * resets its statistics.
+   * The callback is stored in place and must fit in ShellCallbackSize bytes,
+   * which is checked at compile time.
    *
    * @param name The name of the command to register
    * @param cb The callback function to execute when the command is invoked
@@ -52,11 +600,43 @@ struct tiny {
       return Error::NullPointerMember;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    registry_[name] = std::move(cb);
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+    // Only registration replaces the head, so the current node stays alive
+    // while the mutex is held
+    auto* next = new registry_node{
+        node_of(head_.load(std::memory_order_acquire))->commands};
+    auto shared = std::make_shared<const command_entry>(std::string{name},
+                                                   std::move(cb));
+    auto& commands = next->commands;
+    if (auto index = commands.names.find(name); index.has_value()) {
+      shared->cache_ttl.store(
+          commands.callbacks[*index]->cache_ttl.load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      commands.callbacks[*index] = std::move(shared);
+    } else {
+      commands.names.insert(name, static_cast<PrefixIndex::value_type>(
+                                      commands.callbacks.size()));
+      commands.callbacks.push_back(std::move(shared));
+    }
+    retire(head_.exchange(pack(next, 0), std::memory_order_acq_rel));
+    cache_.invalidate(name);
     return Error::Ok;
   }
 
+  /**
+   * @brief Registers a command whose handler takes its arguments typed, as
+   * in Error(OutputBufferType&, int, float, std::string_view)
+   *
+   * Argument count and conversions are checked before the handler runs, see
+   * typed_command.
+   *
+   * @return The same as registerCommand(name, cb)
+   */
+  template <typed_handler<OutputBufferType> Fn>
+  Error registerCommand(std::string_view name, Fn fn) {
+    return registerCommand(name, callback{typed_command<Fn>{std::move(fn)}});
+  }
+
   /**
    * @brief Checks if a command exists in the registry
    * @param name The name of the command to check
@@ -64,7 +644,30 @@ struct tiny {
    *
    */
   bool isCommandValid(std::string_view name) const {
-    return registry_.find(name) != registry_.end();
+    return find(name).has_value();
+  }
+
+  /**
+   * @brief Lets commands be called by any prefix that matches only one
+   * command, e.g. "stat" for "statistics"; exact names always win
+   */
+  void setPrefixMatching(bool enabled) noexcept {
+    prefix_matching_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Calls fn(name) for every command starting with prefix, in
+   * lexicographic order
+   *
+   * fn sees the commands registered when the call started.
+   *
+   * @return The number of matching commands
+   */
+  std::size_t completeCommand(std::string_view prefix,
+                              function_ref<void(std::string_view)> fn) const {
+    return snapshot()->names.complete(prefix, [&](std::string_view name, auto) {
+          fn(name);
+        });
   }
 
   /**
@@ -72,6 +675,8 @@ struct tiny {
    *
    * This function processes the input string, tokenizes it, validates the command,
    * and executes the corresponding callback if found in the registry.
+   * Calls are serialized on an internal session; use the overload taking a
+   * session to run commands in parallel.
    *
    * @tparam output_interface Auto-deduced output interface type that supports write operations
    * 
@@ -80,7 +685,7 @@ struct tiny {
    *
    * @return Error code indicating the execution status:
    *         - Error::Ok on successful execution
-   *         - Error::EmptyInput if input string is empty
+   *         - Error::EmptyInput if input string is empty or only whitespace
    *         - Error::InvalidCommand if command is not valid
    *         - Error::NullPointerMember if command has no registered callback
    *         - Tokenizer-specific errors if tokenization fails
@@ -94,53 +699,385 @@ struct tiny {
    */
   Error execute(std::string_view input, output_interface auto& output) {
     std::lock_guard<std::mutex> lock(mutex_);
-    static constexpr std::string_view invalid_command_message =
-        "Invalid command\n";
-    static constexpr std::string_view no_command_message =
-        "Command has no executable code\n";
+    return execute(session_, input, output);
+  }
 
+  /**
+   * @brief Executes a shell command using the tokenizer and output buffer of
+   * the given session
+   *
+   * The registry lookup takes no lock, so threads with their own sessions run
+   * commands in parallel, also while commands are being registered.
+   *
+   * @return The same as execute(input, output)
+   */
+  Error execute(session_type& session, std::string_view input,
+                output_interface auto& output) const {
     if (input.empty()) {
       return Error::EmptyInput;
     }
 
-    auto tokenizer_result = tokenizer_.tokenize(input);
-    if (!tokenizer_result.has_value()) {
-      return tokenizer_result.error();
+    [[maybe_unused]] detail::stopwatch<CollectStats> watch{};
+    // Read before the lookup: a replacement registered after it is seen
+    // invalidates the cache, so output of the replaced callback is not stored
+    const auto generation = cache_.generation();
+    // Resolve the command from the first token alone, so unknown commands are
+    // rejected without scanning the rest of the line
+    auto first = TokenRange<>{input}.begin();
+    if (first == std::default_sentinel) {
+      return Error::EmptyInput;
     }
 
-    auto command = tokenizer_.tokens_span()[0].view(input);
-    if (!isCommandValid(command)) {
-      output.write(invalid_command_message);
+    auto command = *first;
+    auto command_cb = find(command);
+    if (!command_cb.has_value()) {
+      output.write(command_cb.error() == Error::MaximumSizeExceeded
+                       ? detail::ambiguous_command_message
+                       : detail::invalid_command_message);
       return Error::InvalidCommand;
     }
 
-    auto args = TokenViews::create(input, tokenizer_.tokens_span().subspan(1));
-    if (!args.has_value()) {
-      return args.error();
+    const auto& entry = **command_cb;
+    if (entry.fn == nullptr) {
+      output.write(detail::no_command_message);
+      return Error::NullPointerMember;
+    }
+
+    const std::chrono::nanoseconds ttl{
+        entry.cache_ttl.load(std::memory_order_relaxed)};
+    auto run = [&](auto& fn, auto& out) {
+      if (ttl.count() > 0) {
+        return session.run_cached(fn, command, input, out, cache_, entry.name,
+                                  ttl, generation);
+      }
+      return session.run(fn, command, input, out);
+    };
+    if constexpr (CollectStats) {
+      return run_measured(entry, watch, output, run);
+    } else {
+      return run(entry.fn, output);
+    }
+  }
+
+  /**
+   * @brief Marks a command as idempotent and caches its output for ttl
+   *
+   * Lines with the same command and argument tokens are then answered from
+   * the cache, without calling the command, until ttl has passed or the
+   * cache is invalidated. Only output of calls that return Error::Ok is
+   * cached. The setting is kept when the command is replaced, but its
+   * cached output is dropped.
+   *
+   * @param ttl How long output stays valid; 0 stops caching the command
+   * @return Error::Ok, or Error::InvalidCommand if there is no such command
+   */
+  Error setCommandCaching(std::string_view name,
+                          std::chrono::nanoseconds ttl) {
+    // Keeps a concurrent replacement from copying the previous setting
+    std::lock_guard<std::mutex> lock(registration_mutex_);
+    auto found = find(name);
+    if (!found.has_value()) {
+      return Error::InvalidCommand;
     }
+    (*found)->cache_ttl.store(std::max<std::int64_t>(ttl.count(), 0),
+                              std::memory_order_relaxed);
+    cache_.invalidate((*found)->name);
+    return Error::Ok;
+  }
 
-    auto command_cb = registry_[command];
-    if (command_cb == nullptr) {
-      output.write(no_command_message);
+  /**
+   * @brief Drops all cached output, e.g. after the state that idempotent
+   * commands report has changed
+   */
+  void invalidateCache() { cache_.invalidate(); }
+
+  /**
+   * @brief Drops the cached output of one command
+   */
+  void invalidateCache(std::string_view name) { cache_.invalidate(name); }
+
+  /**
+   * @brief Returns the id of a command for call()
+   *
+   * A command keeps its id while the shell lives, also when it is replaced.
+   *
+   * @return The id, or Error::InvalidCommand if there is no command with
+   * exactly that name
+   */
+  std::expected<std::uint32_t, Error> commandId(std::string_view name) const {
+    auto index = snapshot()->names.find(name);
+    if (!index.has_value()) {
+      return std::unexpected(Error::InvalidCommand);
+    }
+    return *index;
+  }
+
+  /**
+   * @brief Runs a command by id with arguments that are already split, so
+   * nothing is tokenized; used by binary front ends such as rpc_channel
+   *
+   * @return The same as execute(), with Error::InvalidCommand for unknown ids
+   */
+  Error call(session_type& session, std::uint32_t id, arguments args,
+             output_interface auto& output) const {
+    [[maybe_unused]] detail::stopwatch<CollectStats> watch{};
+    std::shared_ptr<const command_entry> found{};
+    if (auto commands = snapshot(); id < commands->callbacks.size()) {
+      found = commands->callbacks[id];
+    }
+    if (found == nullptr) {
+      output.write(detail::invalid_command_message);
+      return Error::InvalidCommand;
+    }
+
+    const auto& entry = *found;
+    if (entry.fn == nullptr) {
+      output.write(detail::no_command_message);
       return Error::NullPointerMember;
     }
 
-    output_buffer_.clear();
-    auto command_result = command_cb(command, *args, output_buffer_);
-    if (command_result != Error::Ok) {
-      output.write(output_buffer_.data(), output_buffer_.size());
-      return command_result;
+    if constexpr (CollectStats) {
+      return run_measured(entry, watch, output, [&](auto& fn, auto& counted) {
+        return session.call(fn, entry.name, args, counted);
+      });
+    } else {
+      return session.call(entry.fn, entry.name, args, output);
     }
+  }
 
-    auto output_result =
-        output.write(output_buffer_.data(), output_buffer_.size());
-    return output_result.error_or(Error::Ok);
+  /**
+   * @brief Returns the statistics of a command
+   *
+   * The pointer keeps the statistics alive after the command is replaced, but
+   * they stop being updated then.
+   *
+   * @return The statistics, or the same errors as a lookup by execute()
+   */
+  std::expected<std::shared_ptr<const command_stats>, Error> commandStats(
+      std::string_view name) const
+    requires CollectStats
+  {
+    auto found = find(name);
+    if (!found.has_value()) {
+      return std::unexpected(found.error() == Error::MaximumSizeExceeded
+                                 ? found.error()
+                                 : Error::InvalidCommand);
+    }
+    return std::shared_ptr<const command_stats>(*found, &(*found)->stats);
+  }
+
+  /**
+   * @brief Runs a multi-line script with pipelines, see session::run_script
+   *
+   * Calls are serialized on the internal session, like execute(input, output).
+   */
+  Error executeScript(std::string_view script, output_interface auto& output,
+                      on_error policy = on_error::stop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return executeScript(session_, script, output, policy);
+  }
+
+  /**
+   * @brief Runs a multi-line script with pipelines on the given session
+   */
+  Error executeScript(session_type& session, std::string_view script,
+                      output_interface auto& output,
+                      on_error policy = on_error::stop) const {
+    return session.run_script(
+        script, output, policy,
+        [&](std::string_view line, detail::string_sink& sink) {
+          return execute(session, line, sink);
+        });
   }
 
  private:
-  registry registry_{};
-  OutputBufferType output_buffer_{};
-  Tokenizer<MaxTokens> tokenizer_{};
+  /**
+   * @brief A registry with the count that decides when it can be freed
+   *
+   * The head word packs the pointer to the current node with the number of
+   * readers that acquired it, which fits in the low bits the alignment
+   * leaves free. When registerCommand replaces the node it adds that
+   * external count to `released`, while every reader that acquired the node
+   * subtracts one from it once the node is no longer current. Whoever brings
+   * it to zero frees the node. The alignment makes a node take at least 1
+   * KiB; only the current node and those still being read are alive.
+   */
+  struct alignas(1024) registry_node {
+    registry commands;
+    std::atomic<std::int64_t> released{0};
+  };
+
+  static constexpr std::uintptr_t ReaderMask = alignof(registry_node) - 1;
+  static_assert(std::atomic<std::uintptr_t>::is_always_lock_free);
+
+  static std::uintptr_t pack(const registry_node* node,
+                             std::uintptr_t readers) noexcept {
+    return reinterpret_cast<std::uintptr_t>(node) | readers;
+  }
+  static registry_node* node_of(std::uintptr_t head) noexcept {
+    return reinterpret_cast<registry_node*>(head & ~ReaderMask);
+  }
+
+  /**
+   * @brief Holds the registry that was current when it was created
+   *
+   * Acquiring and releasing are a compare-exchange each on the head word,
+   * so lookups never block and never wait for registration.
+   */
+  class registry_ref {
+   public:
+    explicit registry_ref(const tiny& shell) noexcept
+        : shell_(shell), node_(shell.acquire()) {}
+    ~registry_ref() { shell_.release(node_); }
+    registry_ref(const registry_ref&) = delete;
+    registry_ref& operator=(const registry_ref&) = delete;
+
+    const registry* operator->() const noexcept { return &node_->commands; }
+
+   private:
+    const tiny& shell_;
+    registry_node* node_;
+  };
+
+  /**
+   * @brief Returns the current registry; the reference keeps it alive after
+   * registerCommand has replaced it
+   */
+  registry_ref snapshot() const noexcept { return registry_ref{*this}; }
+
+  registry_node* acquire() const noexcept {
+    auto head = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      if ((head & ReaderMask) == ReaderMask) {
+        // As many readers as the count holds; wait for one to leave
+        std::this_thread::yield();
+        head = head_.load(std::memory_order_relaxed);
+      } else if (head_.compare_exchange_weak(head, head + 1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+        return node_of(head);
+      }
+    }
+  }
+
+  void release(registry_node* node) const noexcept {
+    // While the node is current its address cannot be reused, so a head
+    // that points at it still counts this reader
+    auto head = head_.load(std::memory_order_relaxed);
+    while (node_of(head) == node) {
+      if (head_.compare_exchange_weak(head, head - 1,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    if (node->released.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete node;
+    }
+  }
+
+  /**
+   * @brief Frees a replaced head once the readers it counted are done
+   */
+  static void retire(std::uintptr_t head) noexcept {
+    auto* node = node_of(head);
+    const auto readers = static_cast<std::int64_t>(head & ReaderMask);
+    if (node->released.fetch_add(readers, std::memory_order_acq_rel) ==
+        -readers) {
+      delete node;
+    }
+  }
+
+  /**
+   * @brief Runs a command and records its latencies, result and output size
+   *
+   * @param run Runs the command as run(fn, output) through the session
+   */
+  template <typename Run>
+  Error run_measured(const command_entry& entry,
+                     detail::stopwatch<CollectStats>& watch,
+                     output_interface auto& output, Run&& run) const {
+    auto& stats = entry.stats;
+    stats.dispatch.record(watch.lap());
+
+    detail::counting_output<std::remove_reference_t<decltype(output)>>
+        counted{output};
+    auto measured = [&](std::string_view name, arguments args,
+                        OutputBufferType& buffer) {
+      stats.tokenize.record(watch.lap());
+      auto command_result = entry.fn(name, args, buffer);
+      stats.callback.record(watch.lap());
+      return command_result;
+    };
+    auto result = run(measured, counted);
+    stats.record(result, counted.bytes);
+    return result;
+  }
+
+  /**
+   * @brief The built-in stats command
+   */
+  Error writeStats(arguments args, OutputBufferType& output) const {
+    if (args.size() > 1) {
+      return Error::InvalidArgument;
+    }
+    if (args.size() == 1) {
+      auto stats = commandStats(*args[0]);
+      if (!stats.has_value()) {
+        return stats.error();
+      }
+      return (*stats)->write_details(output);
+    }
+
+    const auto commands = snapshot();
+    Error result = Error::Ok;
+    commands->names.complete("", [&](std::string_view name, auto index) {
+      if (result == Error::Ok) {
+        result = output.write(name).error_or(Error::Ok);
+      }
+      if (result == Error::Ok) {
+        result = output.write(" ").error_or(Error::Ok);
+      }
+      if (result == Error::Ok) {
+        result = commands->callbacks[index]->stats.write_summary(output);
+      }
+    });
+    return result;
+  }
+
+  /**
+   * @brief Returns the entry of a command
+   *
+   * The entry is kept alive by the shared pointer after the registry
+   * snapshot has been replaced.
+   *
+   * @return The entry, Error::InvalidCommand if there is no such command
+   * or Error::MaximumSizeExceeded if an abbreviation matches several
+   */
+  std::expected<std::shared_ptr<const command_entry>, Error> find(
+      std::string_view name) const {
+    const auto commands = snapshot();
+    if (auto index = commands->names.find(name); index.has_value()) {
+      return commands->callbacks[*index];
+    }
+
+    if (prefix_matching_.load(std::memory_order_relaxed)) {
+      auto match = commands->names.resolve(name);
+      if (match.has_value()) {
+        return commands->callbacks[match->value];
+      }
+      if (match.error() == Error::MaximumSizeExceeded) {
+        return std::unexpected(match.error());
+      }
+    }
+    return std::unexpected(Error::InvalidCommand);
+  }
+
+  mutable std::atomic<std::uintptr_t> head_{pack(new registry_node{}, 0)};
+  std::atomic<bool> prefix_matching_{false};
+  mutable response_cache cache_{};
+  std::mutex registration_mutex_{};
+  session_type session_{};
   std::mutex mutex_{};
 };
 };  // namespace shell
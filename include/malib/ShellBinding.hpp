@@ -0,0 +1,201 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "malib/CharClasses.hpp"
+#include "malib/Error.hpp"
+#include "malib/Format.hpp"
+#include "malib/StringConverter.hpp"
+#include "malib/Token.hpp"
+#include "malib/TokenDecoder.hpp"
+
+namespace malib {
+namespace shell {
+
+/**
+ * @brief Types a typed command can take its arguments as
+ *
+ * Numbers are parsed with StringConverter::to_number_exact, so the whole
+ * token must be the number: "1x", or "2.9" for an integer, are rejected.
+ * std::string_view gets the token without its surrounding quotes; tokens that
+ * need more rewriting than that are rejected, std::string takes them with all
+ * quotes removed.
+ */
+template <typename T>
+concept command_argument =
+    (std::integral<T> && !std::same_as<T, bool>) || std::floating_point<T> ||
+    std::same_as<T, std::string_view> || std::same_as<T, std::string>;
+
+namespace detail {
+/**
+ * @brief The result and parameter types of a function pointer or of a class
+ * with a single, non-template operator()
+ */
+template <typename T>
+struct signature {};
+
+template <typename T>
+  requires requires { &T::operator(); }
+struct signature<T> : signature<decltype(&T::operator())> {};
+
+template <typename R, typename... Params>
+struct signature<R (*)(Params...)> {
+  using result = R;
+  using parameters = std::tuple<Params...>;
+};
+
+template <typename R, typename... Params>
+struct signature<R (*)(Params...) noexcept> : signature<R (*)(Params...)> {};
+
+template <typename R, typename C, typename... Params>
+struct signature<R (C::*)(Params...)> : signature<R (*)(Params...)> {};
+
+template <typename R, typename C, typename... Params>
+struct signature<R (C::*)(Params...) const> : signature<R (*)(Params...)> {};
+
+template <typename R, typename C, typename... Params>
+struct signature<R (C::*)(Params...) noexcept>
+    : signature<R (*)(Params...)> {};
+
+template <typename R, typename C, typename... Params>
+struct signature<R (C::*)(Params...) const noexcept>
+    : signature<R (*)(Params...)> {};
+
+/**
+ * @brief The signature of a handler called with an Output& first; generic
+ * handlers such as [](auto& output, int) are resolved for Output
+ */
+template <typename Fn, typename Output>
+struct handler_signature : signature<Fn> {};
+
+template <typename Fn, typename Output>
+  requires requires { &Fn::template operator()<Output>; }
+struct handler_signature<Fn, Output>
+    : signature<decltype(&Fn::template operator()<Output>)> {};
+
+template <typename Parameters, typename Output>
+inline constexpr bool takes_output_first = false;
+
+template <typename Output, typename... Rest>
+inline constexpr bool takes_output_first<std::tuple<Output&, Rest...>,
+                                         Output> = true;
+
+template <typename T>
+Error parse_argument(std::string_view token, T& value) {
+  using decoder = TokenDecoder<char_classes::shell>;
+  if constexpr (std::same_as<T, std::string_view>) {
+    auto decoded = decoder::view(token);
+    if (!decoded.has_value()) {
+      return decoded.error();
+    }
+    value = *decoded;
+    return Error::Ok;
+  } else if constexpr (std::same_as<T, std::string>) {
+    if (auto direct = decoder::view(token); direct.has_value()) {
+      value.assign(*direct);
+      return Error::Ok;
+    }
+    value.resize(decoder::decoded_size(token));
+    std::span<char> arena{value};
+    return decoder::decode(token, arena).error_or(Error::Ok);
+  } else {
+    return StringConverter::to_number_exact(token, value);
+  }
+}
+}  // namespace detail
+
+/**
+ * @brief A callable taking an Output& followed by typed command arguments,
+ * e.g. Error(Output&, int, float, std::string_view)
+ */
+template <typename Fn, typename Output>
+concept typed_handler = detail::takes_output_first<
+    typename detail::handler_signature<std::decay_t<Fn>, Output>::parameters,
+    Output>;
+
+/**
+ * @brief Adapts a handler with typed parameters to a shell command
+ *
+ * The handler's first parameter receives the command output, the others the
+ * command arguments, converted from their tokens. The conversions are picked
+ * at compile time from the parameter types and the handler is called
+ * directly, so the adapter adds no indirection to a command.
+ *
+ * A line with a different number of arguments fails with
+ * Error::InvalidArgument and "Expected N arguments\n"; an argument that does
+ * not convert fails with the conversion error, InvalidArgument or
+ * ResultOutOfRange, and "Invalid argument N\n", counting from 1. The handler
+ * only runs when every argument converted.
+ *
+ * @code
+ * shell.registerCommand("add", [](auto& output, int a, int b) {
+ *   return malib::format_to<"{}">(output, a + b).error_or(malib::Error::Ok);
+ * });
+ * @endcode
+ */
+template <typename Fn>
+class typed_command {
+ public:
+  constexpr explicit typed_command(Fn fn) : fn_(std::move(fn)) {}
+
+  template <typename Output>
+  Error operator()(std::string_view, TokenViews args, Output& output) const {
+    static_assert(typed_handler<Fn, Output>,
+                  "Typed commands must take the output as their first "
+                  "parameter, by reference");
+    using parameters =
+        typename detail::handler_signature<Fn, Output>::parameters;
+    static_assert(
+        std::is_same_v<
+            typename detail::handler_signature<Fn, Output>::result, Error>,
+        "Typed commands must return malib::Error");
+    return invoke<parameters>(
+        args, output,
+        std::make_index_sequence<std::tuple_size_v<parameters> - 1>{});
+  }
+
+ private:
+  template <typename Parameters, std::size_t I>
+  using argument_t =
+      std::remove_cvref_t<std::tuple_element_t<I + 1, Parameters>>;
+
+  template <typename Parameters, typename Output, std::size_t... I>
+  Error invoke(TokenViews args, Output& output,
+               std::index_sequence<I...>) const {
+    static_assert((command_argument<argument_t<Parameters, I>> && ...),
+                  "Typed command arguments must be integers other than bool, "
+                  "floating point numbers, std::string_view or std::string");
+    constexpr auto arity = sizeof...(I);
+    if (args.size() != arity) {
+      format_to<"Expected {} arguments\n">(output, arity);
+      return Error::InvalidArgument;
+    }
+
+    std::tuple<argument_t<Parameters, I>...> values{};
+    Error result = Error::Ok;
+    std::size_t position = 0;
+    const bool converted =
+        ((position = I + 1,
+          result = detail::parse_argument(*args[I], std::get<I>(values)),
+          result == Error::Ok) &&
+         ...);
+    if (!converted) {
+      format_to<"Invalid argument {}\n">(output, position);
+      return result;
+    }
+    return fn_(output, std::get<I>(values)...);
+  }
+
+  Fn fn_;
+};
+
+}  // namespace shell
+}  // namespace malib
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace malib {
+namespace shell {
+
+/**
+ * @brief Output of idempotent commands, keyed by their command line
+ *
+ * Keys are built by the session from the command name and the argument
+ * tokens, so lines that differ only in whitespace or in how the command was
+ * abbreviated share one entry. Outputs are kept as shared immutable strings:
+ * a hit copies a pointer under a shared lock and writes the bytes after
+ * releasing it, so readers never wait for each other or for slow outputs.
+ *
+ * The cache holds at most capacity entries. When it is full, expired entries
+ * are dropped, and if none expired the new output is simply not cached.
+ *
+ * Every invalidation advances a generation counter. A caller reads
+ * generation() before it runs a command and passes it to store(), which
+ * drops the output if the cache was invalidated in between, so a command
+ * that was running during an invalidation cannot put stale output back.
+ */
+class response_cache {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  explicit response_cache(std::size_t capacity = 1024) : capacity_(capacity) {}
+
+  /**
+   * @brief Returns the output stored for key, or nullptr if there is none or
+   * it expired
+   */
+  std::shared_ptr<const std::string> find(std::string_view key) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.expires <= clock::now()) {
+      return nullptr;
+    }
+    return it->second.output;
+  }
+
+  /**
+   * @brief Returns the current generation, to be passed to store()
+   */
+  [[nodiscard]] std::uint64_t generation() const noexcept {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Stores the output for key until ttl has passed, unless the cache
+   * was invalidated since generation was read
+   */
+  void store(std::string_view key, std::string_view output,
+             std::chrono::nanoseconds ttl, std::uint64_t generation) {
+    entry added{std::make_shared<const std::string>(output),
+                clock::now() + ttl};
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    if (generation != generation_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (auto it = entries_.find(key); it != entries_.end()) {
+      it->second = std::move(added);
+      return;
+    }
+
+    if (entries_.size() >= capacity_) {
+      const auto now = clock::now();
+      std::erase_if(entries_, [now](const auto& item) {
+        return item.second.expires <= now;
+      });
+      if (entries_.size() >= capacity_) {
+        return;
+      }
+    }
+    entries_.emplace(std::string{key}, std::move(added));
+  }
+
+  /**
+   * @brief Drops every entry
+   */
+  void invalidate() {
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_release);
+    entries_.clear();
+  }
+
+  /**
+   * @brief Drops the entries of one command, whatever its arguments
+   *
+   * Advances the generation too, so outputs of other commands that are
+   * running at the same time are not stored either.
+   */
+  void invalidate(std::string_view command) {
+    std::lock_guard<std::shared_mutex> lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_release);
+    std::erase_if(entries_, [command](const auto& item) {
+      std::string_view key = item.first;
+      return key.starts_with(command) &&
+             (key.size() == command.size() || key[command.size()] == '\0');
+    });
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+ private:
+  struct entry {
+    std::shared_ptr<const std::string> output;
+    clock::time_point expires;
+  };
+
+  struct key_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const noexcept {
+      return std::hash<std::string_view>{}(key);
+    }
+  };
+
+  std::unordered_map<std::string, entry, key_hash, std::equal_to<>>
+      entries_{};
+  mutable std::shared_mutex mutex_{};
+  std::atomic<std::uint64_t> generation_{0};
+  std::size_t capacity_;
+};
+
+}  // namespace shell
+}  // namespace malib
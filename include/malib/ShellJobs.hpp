@@ -0,0 +1,394 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "malib/Error.hpp"
+#include "malib/RingBuffer.hpp"
+#include "malib/Shell.hpp"
+#include "malib/StringConverter.hpp"
+#include "malib/Tokenizer.hpp"
+#include "malib/WaitableQueue.hpp"
+#include "malib/concepts.hpp"
+
+namespace malib {
+namespace shell {
+
+enum class job_state : std::uint8_t {
+  queued,
+  running,
+  done,
+  cancelled,
+};
+
+/**
+ * @brief The output of an asynchronous command
+ *
+ * Writes go into a ring buffer that keeps the latest ProgressSize bytes, so a
+ * chatty job never blocks and never grows. The built-in wait command drains
+ * it into the shell output.
+ */
+template <std::size_t ProgressSize>
+class job_output {
+ public:
+  explicit job_output(std::stop_token stop) noexcept : stop_(std::move(stop)) {}
+
+  std::expected<std::size_t, Error> write(const char* data, std::size_t size) {
+    return progress_.write(data, size);
+  }
+
+  std::expected<std::size_t, Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+
+  /**
+   * @brief Checks whether the job was cancelled; long running commands should
+   * poll this and return early
+   */
+  [[nodiscard]] bool stop_requested() const noexcept {
+    return stop_.stop_requested();
+  }
+
+  /**
+   * @brief Moves the buffered progress to output
+   */
+  Error drain(output_interface auto& output) {
+    char chunk[64];
+    while (true) {
+      auto read = progress_.read(chunk, sizeof(chunk));
+      if (!read.has_value() || *read == 0) {
+        return read.error_or(Error::Ok);
+      }
+      auto written = output.write(chunk, *read);
+      if (!written.has_value()) {
+        return written.error();
+      }
+    }
+  }
+
+ private:
+  std::stop_token stop_;
+  RingBuffer<char, ProgressSize, OverwritePolicy::Overwrite> progress_{};
+};
+
+/**
+ * @brief Runs long commands of a shell on a pool of worker threads
+ *
+ * Commands registered through the pool are registered in the shell as
+ * commands that copy their line into a new job, queue it and print the job
+ * id as "[id]\n" right away. A worker then tokenizes the copy and calls the
+ * asynchronous callback with a job_output for its progress.
+ *
+ * The pool also registers three built-in commands in the shell:
+ * - jobs: lists every job as "id state name"
+ * - wait id: prints the remaining progress of a job that has ended, forgets
+ *   the job and returns the job's result. For a job that is still queued or
+ *   running it prints the state, "queued\n" or "running\n", and returns
+ *   Error::Ok right away; callers poll until the job ends
+ * - cancel id: requests the job to stop; queued jobs never start
+ *
+ * wait does not block because the shell runs commands on its shared session
+ * under a lock: a wait blocking there would keep cancel, and every other
+ * command, from running until the job ends.
+ *
+ * wait writes the progress through the shell's output buffer, so progress
+ * larger than that buffer needs a larger buffer or a stream_writer. The pool
+ * must outlive every use of the commands it registered.
+ *
+ * Finished jobs that nobody waits for, such as fire-and-forget or cancelled
+ * jobs, are kept for jobs and wait until more than history jobs have
+ * finished; then the oldest of them is forgotten with its line and progress.
+ * So the pool holds at most history finished jobs however long it runs.
+ *
+ * @tparam Shell The shell type, e.g. tiny<>
+ * @tparam ProgressSize Size of the progress ring buffer of every job
+ * @tparam MaxTokens Maximum number of tokens of an asynchronous command line
+ */
+template <typename Shell, std::size_t ProgressSize = 1024,
+          std::size_t MaxTokens = ShellMaxTokensLength>
+class job_pool {
+ public:
+  using output_type = job_output<ProgressSize>;
+  using async_callback =
+      std::function<Error(std::string_view, arguments, output_type&)>;
+
+  /**
+   * @param shell The shell that receives the commands
+   * @param threads Number of worker threads
+   * @param history Number of finished jobs kept until they are waited for
+   */
+  explicit job_pool(Shell& shell, std::size_t threads = 1,
+                    std::size_t history = 64)
+      : shell_(shell), history_(history) {
+    shell_.registerCommand(
+        "jobs", [this](std::string_view, arguments, auto& output) {
+          return list(output);
+        });
+    shell_.registerCommand(
+        "wait", [this](std::string_view, arguments args, auto& output) {
+          auto found = find(args);
+          if (!found.has_value()) {
+            return found.error();
+          }
+          return wait(**found, output);
+        });
+    shell_.registerCommand(
+        "cancel", [this](std::string_view, arguments args, auto&) {
+          auto found = find(args);
+          if (!found.has_value()) {
+            return found.error();
+          }
+          (*found)->stop.request_stop();
+          return Error::Ok;
+        });
+
+    threads = std::max<std::size_t>(threads, 1);
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+  job_pool(const job_pool&) = delete;
+  job_pool& operator=(const job_pool&) = delete;
+
+  /**
+   * @brief Cancels all jobs and waits for the running ones to return
+   */
+  ~job_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto& [id, job] : jobs_) {
+        job->stop.request_stop();
+      }
+    }
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      queue_.push(nullptr);
+    }
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * @brief Registers a command that runs on the pool
+   *
+   * @return The result of registering the queuing command in the shell, or
+   * Error::NullPointerMember if the callback is nullptr
+   */
+  Error registerCommand(std::string_view name, async_callback cb) {
+    if (cb == nullptr) {
+      return Error::NullPointerMember;
+    }
+
+    auto shared = std::make_shared<const async_callback>(std::move(cb));
+    return shell_.registerCommand(
+        name, [this, shared](std::string_view command, arguments args,
+                             auto& output) {
+          const auto id = submit(shared, command, args);
+          std::array<char, 24> text{'['};
+          auto [end, ec] = std::to_chars(text.data() + 1,
+                                         text.data() + text.size() - 2, id);
+          *end++ = ']';
+          *end++ = '\n';
+          return output.write(text.data(), end - text.data())
+              .error_or(Error::Ok);
+        });
+  }
+
+  /**
+   * @brief Returns the state of a job, or Error::InvalidArgument if there is
+   * no job with that id
+   */
+  std::expected<job_state, Error> state(std::size_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    return it->second->state.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct job {
+    std::size_t id;
+    std::string line;
+    std::shared_ptr<const async_callback> callback;
+    std::stop_source stop{};
+    output_type output{stop.get_token()};
+    std::atomic<job_state> state{job_state::queued};
+    /// Written before state is set to done or cancelled
+    Error result{Error::Ok};
+
+    std::string_view name() const noexcept {
+      return std::string_view{line}.substr(0, line.find(' '));
+    }
+  };
+
+  static constexpr std::string_view state_name(job_state state) noexcept {
+    switch (state) {
+      case job_state::queued:
+        return "queued";
+      case job_state::running:
+        return "running";
+      case job_state::done:
+        return "done";
+      case job_state::cancelled:
+        return "cancelled";
+    }
+    return "";
+  }
+
+  /**
+   * @brief Copies the command line into a new job and queues it
+   *
+   * Tokens keep their quotes, so joining them with spaces gives a line that
+   * tokenizes to the same arguments.
+   */
+  std::size_t submit(std::shared_ptr<const async_callback> callback,
+                     std::string_view command, arguments args) {
+    auto new_job = std::make_shared<job>(
+        next_id_.fetch_add(1, std::memory_order_relaxed), std::string{command},
+        std::move(callback));
+    for (auto arg : args) {
+      new_job->line.push_back(' ');
+      new_job->line.append(arg);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.emplace(new_job->id, new_job);
+    }
+    queue_.push(new_job);
+    return new_job->id;
+  }
+
+  void work() {
+    Tokenizer<MaxTokens> tokenizer{};
+    while (auto next = queue_.pop()) {
+      auto& current = *next;
+      Error result = Error::Ok;
+      if (current.stop.stop_requested()) {
+        finish(current, job_state::cancelled, Error::Ok);
+        continue;
+      }
+
+      current.state.store(job_state::running, std::memory_order_release);
+      auto args = detail::tokenize_arguments(tokenizer, current.line);
+      if (!args.has_value()) {
+        result = args.error();
+      } else {
+        result = (*current.callback)(current.name(), *args, current.output);
+      }
+      finish(current,
+             current.stop.stop_requested() ? job_state::cancelled
+                                           : job_state::done,
+             result);
+    }
+  }
+
+  /**
+   * @brief Ends a job and forgets the oldest finished jobs beyond history_
+   *
+   * The history is updated before the state, so a caller that sees the job
+   * end also sees the jobs it displaced gone. The result is published with
+   * the state.
+   */
+  void finish(job& current, job_state state, Error result) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_.push_back(current.id);
+      while (finished_.size() > history_) {
+        jobs_.erase(finished_.front());
+        finished_.pop_front();
+      }
+    }
+    current.result = result;
+    current.state.store(state, std::memory_order_release);
+  }
+
+  std::expected<std::shared_ptr<job>, Error> find(arguments args) const {
+    std::size_t id = 0;
+    if (args.size() != 1 ||
+        StringConverter::to_number_exact(*args[0], id) != Error::Ok) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    return it->second;
+  }
+
+  Error wait(job& current, output_interface auto& output) {
+    const auto state = current.state.load(std::memory_order_acquire);
+    if (state != job_state::done && state != job_state::cancelled) {
+      for (auto part : {state_name(state), std::string_view{"\n"}}) {
+        auto written = output.write(part.data(), part.size());
+        if (!written.has_value()) {
+          return written.error();
+        }
+      }
+      return Error::Ok;
+    }
+    const auto result = current.result;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.erase(current.id);
+      std::erase(finished_, current.id);
+    }
+
+    auto drained = current.output.drain(output);
+    return result != Error::Ok ? result : drained;
+  }
+
+  Error list(output_interface auto& output) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [id, current] : jobs_) {
+      std::array<char, 24> number{};
+      auto [end, ec] =
+          std::to_chars(number.data(), number.data() + number.size(), id);
+      for (auto part :
+           {std::string_view{number.data(), end}, std::string_view{" "},
+            state_name(current->state.load(std::memory_order_acquire)),
+            std::string_view{" "}, current->name(), std::string_view{"\n"}}) {
+        auto written = output.write(part.data(), part.size());
+        if (!written.has_value()) {
+          return written.error();
+        }
+      }
+    }
+    return Error::Ok;
+  }
+
+  Shell& shell_;
+  std::map<std::size_t, std::shared_ptr<job>> jobs_{};
+  /// Ids of the finished jobs in jobs_, oldest first
+  std::deque<std::size_t> finished_{};
+  std::size_t history_;
+  mutable std::mutex mutex_{};
+  WaitableQueue<std::shared_ptr<job>> queue_{};
+  std::atomic<std::size_t> next_id_{1};
+  std::vector<std::thread> workers_{};
+};
+
+}  // namespace shell
+}  // namespace malib
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "malib/Error.hpp"
+#include "malib/Shell.hpp"
+#include "malib/Token.hpp"
+#include "malib/concepts.hpp"
+
+namespace malib {
+namespace shell {
+
+/**
+ * @brief The frames of the binary shell protocol
+ *
+ * All integers are little endian. Every frame starts with a u32 holding the
+ * number of bytes that follow it.
+ *
+ * A request is
+ * - u32 size
+ * - u32 request id, chosen by the client and copied into the response
+ * - u32 command id, see tiny::commandId()
+ * - u8 argument count, then per argument a u8 length and its bytes
+ *
+ * A response is
+ * - u32 size
+ * - u32 request id
+ * - i32 the Error returned by the command
+ * - the command output, up to the end of the frame
+ */
+namespace rpc {
+inline constexpr std::size_t size_field = 4;
+inline constexpr std::size_t request_header = size_field + 4 + 4 + 1;
+inline constexpr std::size_t response_header = size_field + 4 + 4;
+inline constexpr std::size_t max_argument_size = 255;
+
+/**
+ * @brief A decoded response frame; output points into the decoded input
+ */
+struct response {
+  std::uint32_t id;
+  Error result;
+  std::string_view output;
+  std::size_t frame_size;  ///< bytes of input the frame occupies
+};
+
+namespace detail {
+inline void store_u32(char* out, std::uint32_t value) noexcept {
+  for (std::size_t i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+inline std::uint32_t load_u32(const char* in) noexcept {
+  std::uint32_t value = 0;
+  for (std::size_t i = 0; i < 4; ++i) {
+    value |= std::uint32_t{static_cast<unsigned char>(in[i])} << (8 * i);
+  }
+  return value;
+}
+}  // namespace detail
+
+/**
+ * @brief Writes a request frame to the start of frame
+ *
+ * @return The size of the frame, Error::MaximumSizeExceeded if there are more
+ * than 255 arguments or an argument is longer than 255 bytes, or
+ * Error::BufferFull if frame is too small
+ */
+inline std::expected<std::size_t, Error> encode_request(
+    std::span<char> frame, std::uint32_t request_id, std::uint32_t command_id,
+    std::span<const std::string_view> args) noexcept {
+  if (args.size() > 255) {
+    return std::unexpected(Error::MaximumSizeExceeded);
+  }
+  std::size_t size = request_header;
+  for (auto arg : args) {
+    if (arg.size() > max_argument_size) {
+      return std::unexpected(Error::MaximumSizeExceeded);
+    }
+    size += 1 + arg.size();
+  }
+  if (size > frame.size()) {
+    return std::unexpected(Error::BufferFull);
+  }
+
+  auto out = frame.data();
+  detail::store_u32(out, static_cast<std::uint32_t>(size - size_field));
+  detail::store_u32(out + 4, request_id);
+  detail::store_u32(out + 8, command_id);
+  out[12] = static_cast<char>(args.size());
+  out += request_header;
+  for (auto arg : args) {
+    *out++ = static_cast<char>(arg.size());
+    out = std::copy(arg.begin(), arg.end(), out);
+  }
+  return size;
+}
+
+/**
+ * @brief Decodes the response frame at the start of input
+ *
+ * @return The response, Error::BufferEmpty if input does not hold a whole
+ * frame yet, or Error::InvalidArgument if the frame is too short
+ */
+inline std::expected<response, Error> decode_response(
+    std::span<const char> input) noexcept {
+  if (input.size() < size_field) {
+    return std::unexpected(Error::BufferEmpty);
+  }
+  const std::size_t size = detail::load_u32(input.data());
+  if (size < response_header - size_field) {
+    return std::unexpected(Error::InvalidArgument);
+  }
+  if (input.size() - size_field < size) {
+    return std::unexpected(Error::BufferEmpty);
+  }
+  return response{
+      detail::load_u32(input.data() + 4),
+      static_cast<Error>(static_cast<std::int32_t>(
+          detail::load_u32(input.data() + 8))),
+      std::string_view{input.data() + response_header,
+                       size + size_field - response_header},
+      size + size_field};
+}
+}  // namespace rpc
+
+/**
+ * @brief Runs binary requests on a shell, see the rpc namespace for frames
+ *
+ * Requests name their command by id and carry their arguments already
+ * split, so nothing is formatted, tokenized or looked up by name. Each
+ * channel owns a shell session, so a channel per stream runs in parallel
+ * with other channels and with text sessions of the same shell.
+ *
+ * A client pipelines by sending many requests without waiting: process()
+ * runs every complete frame it is given, in order, and writes all their
+ * responses in a single write. Responses carry the request id, so clients
+ * match them to requests without relying on the order.
+ *
+ * @tparam Shell A shell with call() and commandId(), e.g. tiny<>
+ * @tparam MaxFrameSize Largest request frame accepted, without its size field
+ * @tparam MaxArguments Largest argument count accepted
+ */
+template <typename Shell, std::size_t MaxFrameSize = 4096,
+          std::size_t MaxArguments = ShellMaxTokensLength>
+class rpc_channel {
+  static_assert(MaxFrameSize <= Token::max_offset,
+                "Arguments are passed as Tokens into the frame");
+  static_assert(rpc::max_argument_size <= Token::max_length);
+
+ public:
+  using session_type = typename Shell::session_type;
+
+  explicit rpc_channel(const Shell& shell) : shell_(shell) {}
+
+  /**
+   * @brief Runs the complete request frames at the start of input and writes
+   * one response frame per request to output
+   *
+   * Malformed requests get a response with Error::InvalidArgument, unknown
+   * command ids one with Error::InvalidCommand.
+   *
+   * @return The number of bytes consumed; the rest is an incomplete frame to
+   * pass again with more data. Error::MaximumSizeExceeded if a frame is
+   * larger than MaxFrameSize, after which the stream cannot be read any
+   * further, or the error of the output
+   */
+  std::expected<std::size_t, Error> process(std::span<const char> input,
+                                            output_interface auto& output) {
+    responses_.clear();
+    std::size_t consumed = 0;
+    Error result = Error::Ok;
+    while (input.size() - consumed >= rpc::size_field) {
+      const std::size_t size = rpc::detail::load_u32(input.data() + consumed);
+      if (size > MaxFrameSize) {
+        result = Error::MaximumSizeExceeded;
+        break;
+      }
+      if (input.size() - consumed - rpc::size_field < size) {
+        break;
+      }
+      run_frame({input.data() + consumed + rpc::size_field, size});
+      consumed += rpc::size_field + size;
+    }
+
+    if (!responses_.empty()) {
+      auto written = output.write(responses_.data(), responses_.size());
+      if (!written.has_value()) {
+        return std::unexpected(written.error());
+      }
+    }
+    if (result != Error::Ok) {
+      return std::unexpected(result);
+    }
+    return consumed;
+  }
+
+ private:
+  /**
+   * @brief Runs one request and appends its response to responses_
+   */
+  void run_frame(std::string_view frame) {
+    const auto start = responses_.size();
+    responses_.resize(start + rpc::response_header);
+
+    const std::uint32_t id =
+        frame.size() >= 4 ? rpc::detail::load_u32(frame.data()) : 0;
+    std::uint32_t command = 0;
+    auto args = unpack(frame, command);
+    Error result = args.error_or(Error::Ok);
+    if (args.has_value()) {
+      detail::string_sink sink{responses_};
+      result = shell_.call(session_, command, *args, sink);
+    }
+
+    auto header = responses_.data() + start;
+    rpc::detail::store_u32(
+        header, static_cast<std::uint32_t>(responses_.size() - start -
+                                           rpc::size_field));
+    rpc::detail::store_u32(header + 4, id);
+    rpc::detail::store_u32(header + 8, static_cast<std::uint32_t>(result));
+  }
+
+  /**
+   * @brief Reads the command id and turns the arguments into tokens over
+   * the frame
+   */
+  std::expected<arguments, Error> unpack(std::string_view frame,
+                                         std::uint32_t& command) {
+    constexpr auto header = rpc::request_header - rpc::size_field;
+    if (frame.size() < header) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    command = rpc::detail::load_u32(frame.data() + 4);
+    const std::size_t count = static_cast<unsigned char>(frame[8]);
+    if (count > MaxArguments) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+
+    std::size_t offset = header;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (offset >= frame.size()) {
+        return std::unexpected(Error::InvalidArgument);
+      }
+      const std::size_t length = static_cast<unsigned char>(frame[offset++]);
+      if (frame.size() - offset < length) {
+        return std::unexpected(Error::InvalidArgument);
+      }
+      tokens_[i].offset = static_cast<Token::storage_type>(offset);
+      tokens_[i].length = static_cast<Token::storage_type>(length);
+      offset += length;
+    }
+    if (offset != frame.size()) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    return TokenViews::create(
+        frame, std::span<const Token>{tokens_.data(), count});
+  }
+
+  const Shell& shell_;
+  session_type session_{};
+  std::array<Token, MaxArguments> tokens_{};
+  std::string responses_{};
+};
+
+}  // namespace shell
+}  // namespace malib
@@ -0,0 +1,587 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "malib/Error.hpp"
+#include "malib/Shell.hpp"
+
+namespace malib {
+namespace shell {
+
+namespace detail {
+/**
+ * @brief A byte ring that exposes its free and used space as spans, so data
+ * moves between it and file descriptors without extra copies
+ */
+template <std::size_t Capacity>
+class byte_ring {
+  static_assert(Capacity > 0);
+
+ public:
+  /// The contiguous free space after the last byte
+  std::span<char> writable() noexcept {
+    const auto tail = (head_ + size_) % Capacity;
+    const auto end = tail >= head_ && size_ < Capacity ? Capacity : head_;
+    return {buffer_.data() + tail, size_ == Capacity ? 0 : end - tail};
+  }
+
+  void commit(std::size_t count) noexcept { size_ += count; }
+
+  /// The contiguous used space from the first byte
+  std::span<const char> readable() const noexcept {
+    return {buffer_.data() + head_, std::min(size_, Capacity - head_)};
+  }
+
+  void consume(std::size_t count) noexcept {
+    head_ = (head_ + count) % Capacity;
+    size_ -= count;
+    if (size_ == 0) {
+      head_ = 0;
+    }
+  }
+
+  /// Copies as much of data as fits and returns the number of bytes copied
+  std::size_t push(const char* data, std::size_t count) noexcept {
+    std::size_t copied = 0;
+    while (copied < count) {
+      auto space = writable();
+      if (space.empty()) {
+        break;
+      }
+      const auto chunk = std::min(space.size(), count - copied);
+      std::copy_n(data + copied, chunk, space.begin());
+      commit(chunk);
+      copied += chunk;
+    }
+    return copied;
+  }
+
+  /// Returns the offset of the first c, or size() if there is none
+  std::size_t find(char c) const noexcept {
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (buffer_[(head_ + i) % Capacity] == c) {
+        return i;
+      }
+    }
+    return size_;
+  }
+
+  /// Moves the first count bytes to out
+  void pop(char* out, std::size_t count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = buffer_[(head_ + i) % Capacity];
+    }
+    consume(count);
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] bool full() const noexcept { return size_ == Capacity; }
+
+ private:
+  std::array<char, Capacity> buffer_{};
+  std::size_t head_{0};
+  std::size_t size_{0};
+};
+}  // namespace detail
+
+/**
+ * @brief Serves a shell to many connections from a single thread
+ *
+ * Every connection, whether accepted on a Unix-domain socket, added as one end
+ * of a socketpair or as a PTY master, gets its own shell session and two byte
+ * rings. Input is read without blocking into the input ring and cut into
+ * lines at '\n' (a trailing '\r' is dropped); every complete line is run with
+ * Shell::execute(session, line, output). Command output goes into the output
+ * ring and is written to the connection without blocking; what the
+ * connection does not accept right away is sent when epoll reports it
+ * writable.
+ *
+ * A connection whose output ring is more than half full is not given new
+ * lines until it drains, and it is not read from while its input ring is
+ * full, so a slow peer only ever holds InputSize + OutputSize bytes. Every
+ * command can therefore write OutputSize / 2 bytes; larger output is cut
+ * with Error::BufferFull once neither the ring nor the connection takes
+ * more. A line longer than InputSize is dropped with "Line too long".
+ *
+ * An idle connection costs its rings and session and nothing else, so one
+ * thread serves thousands of them.
+ *
+ * The server keeps one spare descriptor open. When the process runs out of
+ * descriptors, it closes the spare, accepts and closes the pending
+ * connections with it, and reopens it, so a listener that cannot accept does
+ * not keep waking the loop. If the spare cannot be reopened, the listeners
+ * leave epoll until a connection closes.
+ *
+ * @tparam Shell A shell with a session_type, e.g. tiny<>
+ * @tparam InputSize Size of the input ring, and the longest line
+ * @tparam OutputSize Size of the output ring
+ */
+template <typename Shell, std::size_t InputSize = 512,
+          std::size_t OutputSize = 4096>
+class server {
+ public:
+  /**
+   * @brief Creates a server with no connections
+   * @return The server, or Error::InvalidArgument if the epoll instance could
+   * not be created
+   */
+  static std::expected<server, Error> create(Shell& shell) {
+    const int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    const int wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+      ::close(epoll_fd);
+      return std::unexpected(Error::InvalidArgument);
+    }
+
+    server created{shell, epoll_fd, wake_fd, open_spare()};
+    if (created.watch(wake_fd, EPOLLIN, EPOLL_CTL_ADD) != Error::Ok) {
+      return std::unexpected(Error::InvalidArgument);
+    }
+    return created;
+  }
+
+  server(server&& other) noexcept
+      : shell_(other.shell_),
+        epoll_fd_(std::exchange(other.epoll_fd_, -1)),
+        wake_fd_(std::exchange(other.wake_fd_, -1)),
+        spare_fd_(std::exchange(other.spare_fd_, -1)),
+        listening_(other.listening_),
+        listeners_(std::move(other.listeners_)),
+        connections_(std::move(other.connections_)) {}
+
+  server(const server&) = delete;
+  server& operator=(const server&) = delete;
+  server& operator=(server&&) = delete;
+
+  ~server() {
+    for (auto& [fd, conn] : connections_) {
+      ::close(fd);
+    }
+    for (int fd : listeners_) {
+      ::close(fd);
+    }
+    if (wake_fd_ >= 0) {
+      ::close(wake_fd_);
+    }
+    if (spare_fd_ >= 0) {
+      ::close(spare_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+      ::close(epoll_fd_);
+    }
+  }
+
+  /**
+   * @brief Accepts connections on a Unix-domain stream socket at path
+   *
+   * The socket file is not removed first, and not removed on destruction.
+   *
+   * @return Error::Ok, Error::MaximumSizeExceeded if the path is too long, or
+   * Error::InvalidArgument if the socket could not be bound or listened on
+   */
+  Error listen(std::string_view path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+      return Error::MaximumSizeExceeded;
+    }
+    std::copy_n(path.data(), path.size(), address.sun_path);
+
+    const int fd =
+        ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return Error::InvalidArgument;
+    }
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0 ||
+        (listening_ && watch(fd, EPOLLIN, EPOLL_CTL_ADD) != Error::Ok)) {
+      ::close(fd);
+      return Error::InvalidArgument;
+    }
+    listeners_.push_back(fd);
+    return Error::Ok;
+  }
+
+  /**
+   * @brief Serves a connected descriptor, such as a socket or a PTY master
+   *
+   * The server owns the descriptor from now on and closes it when the peer
+   * hangs up or the server is destroyed.
+   *
+   * @return Error::Ok, or Error::InvalidArgument if fd cannot be polled
+   */
+  Error add(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+      return Error::InvalidArgument;
+    }
+
+    struct stat info {};
+    auto conn = std::make_unique<connection>();
+    conn->socket = ::fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+    if (watch(fd, EPOLLIN, EPOLL_CTL_ADD) != Error::Ok) {
+      return Error::InvalidArgument;
+    }
+    connections_.emplace(fd, std::move(conn));
+    return Error::Ok;
+  }
+
+  /**
+   * @brief Waits up to timeout_ms milliseconds for events and handles them
+   * @return The number of events handled, or Error::InvalidArgument if
+   * epoll_wait failed
+   */
+  std::expected<std::size_t, Error> poll(int timeout_ms) {
+    std::array<epoll_event, MaxEvents> events{};
+    const int count =
+        ::epoll_wait(epoll_fd_, events.data(), MaxEvents, timeout_ms);
+    if (count < 0) {
+      if (errno == EINTR) {
+        return 0;
+      }
+      return std::unexpected(Error::InvalidArgument);
+    }
+
+    for (int i = 0; i < count; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == wake_fd_) {
+        std::uint64_t value = 0;
+        [[maybe_unused]] auto ignored = ::read(wake_fd_, &value, sizeof(value));
+        stopped_ = true;
+      } else if (std::find(listeners_.begin(), listeners_.end(), fd) !=
+                 listeners_.end()) {
+        accept_all(fd);
+      } else {
+        handle(fd, events[i].events);
+      }
+    }
+    return static_cast<std::size_t>(count);
+  }
+
+  /**
+   * @brief Handles events until stop() is called
+   */
+  Error run() {
+    stopped_ = false;
+    while (!stopped_) {
+      auto result = poll(-1);
+      if (!result.has_value()) {
+        return result.error();
+      }
+    }
+    return Error::Ok;
+  }
+
+  /**
+   * @brief Makes run() return; may be called from any thread
+   */
+  void stop() noexcept {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] auto ignored = ::write(wake_fd_, &one, sizeof(one));
+  }
+
+  /**
+   * @brief Returns the number of open connections
+   */
+  [[nodiscard]] std::size_t sessions() const noexcept {
+    return connections_.size();
+  }
+
+ private:
+  static constexpr int MaxEvents = 64;
+  static constexpr std::string_view line_too_long_message = "Line too long\n";
+
+  struct connection {
+    typename Shell::session_type session{};
+    detail::byte_ring<InputSize> input{};
+    detail::byte_ring<OutputSize> output{};
+    std::uint32_t events{EPOLLIN};
+    bool socket{false};
+    bool discarding{false};  // skipping the rest of an overlong line
+  };
+
+  /**
+   * @brief The output given to the shell: appends to the output ring, and
+   * makes room by writing to the connection when the ring is full
+   */
+  struct ring_output {
+    connection& conn;
+    int fd;
+
+    std::expected<std::size_t, Error> write(const char* data,
+                                            std::size_t size) {
+      auto copied = conn.output.push(data, size);
+      if (copied < size && fd >= 0 && send(fd, conn)) {
+        copied += conn.output.push(data + copied, size - copied);
+      }
+      if (copied < size) {
+        return std::unexpected(Error::BufferFull);
+      }
+      return copied;
+    }
+
+    std::expected<std::size_t, Error> write(std::string_view view) {
+      return write(view.data(), view.size());
+    }
+  };
+
+  server(Shell& shell, int epoll_fd, int wake_fd, int spare_fd) noexcept
+      : shell_(&shell),
+        epoll_fd_(epoll_fd),
+        wake_fd_(wake_fd),
+        spare_fd_(spare_fd) {}
+
+  static int open_spare() noexcept {
+    return ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+  }
+
+  Error watch(int fd, std::uint32_t events, int operation) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    return ::epoll_ctl(epoll_fd_, operation, fd, &event) == 0
+               ? Error::Ok
+               : Error::InvalidArgument;
+  }
+
+  void accept_all(int listener) {
+    while (true) {
+      const int fd = ::accept4(listener, nullptr, nullptr,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd >= 0) {
+        if (add(fd) != Error::Ok) {
+          ::close(fd);
+        }
+        continue;
+      }
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if ((errno == EMFILE || errno == ENFILE) && reject(listener)) {
+        continue;
+      }
+      return;
+    }
+  }
+
+  /**
+   * @brief Turns away the next pending connection while no descriptor is
+   * left, so the listener stops being readable
+   *
+   * @return true if a connection was turned away and more may be pending
+   */
+  bool reject(int listener) {
+    if (spare_fd_ >= 0) {
+      ::close(spare_fd_);
+      const int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      spare_fd_ = open_spare();
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    if (spare_fd_ < 0) {
+      set_listening(false);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Adds the listeners to epoll or takes them out
+   */
+  void set_listening(bool enabled) {
+    if (listening_ == enabled) {
+      return;
+    }
+    for (int fd : listeners_) {
+      if (enabled) {
+        watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+      } else {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+      }
+    }
+    listening_ = enabled;
+  }
+
+  void handle(int fd, std::uint32_t events) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+      return;
+    }
+    auto& conn = *it->second;
+
+    if (events & EPOLLERR) {
+      close(fd);
+      return;
+    }
+
+    // Lines that arrived before a hang-up still run
+    bool open = true;
+    if (events & (EPOLLIN | EPOLLHUP)) {
+      open = receive(fd, conn);
+    }
+    // Lines held back while the output was full run once it drains
+    bool sent = true;
+    while (sent && run_lines(fd, conn) > 0) {
+      sent = send(fd, conn);
+    }
+    sent = sent && send(fd, conn);
+
+    if (!open || !sent) {
+      close(fd);
+      return;
+    }
+
+    std::uint32_t wanted = 0;
+    if (!conn.input.full()) {
+      wanted |= EPOLLIN;
+    }
+    if (!conn.output.empty()) {
+      wanted |= EPOLLOUT;
+    }
+    if (wanted != conn.events) {
+      conn.events = wanted;
+      watch(fd, wanted, EPOLL_CTL_MOD);
+    }
+  }
+
+  /**
+   * @brief Reads until the input ring is full or nothing is left
+   * @return false once the peer has closed the connection
+   */
+  static bool receive(int fd, connection& conn) {
+    while (true) {
+      if (conn.input.full()) {
+        if (conn.input.find('\n') < conn.input.size()) {
+          return true;
+        }
+        // No line fits: drop what we have and the rest of the line
+        conn.input.consume(conn.input.size());
+        conn.discarding = true;
+        ring_output{conn, -1}.write(line_too_long_message);
+      }
+
+      auto space = conn.input.writable();
+      const auto count = ::read(fd, space.data(), space.size());
+      if (count > 0) {
+        conn.input.commit(static_cast<std::size_t>(count));
+        continue;
+      }
+      if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+      }
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+  }
+
+  /**
+   * @brief Runs the complete lines in the input ring while the output ring
+   * has room for their output
+   * @return The number of lines taken from the input ring
+   */
+  std::size_t run_lines(int fd, connection& conn) {
+    std::size_t lines = 0;
+    while (conn.output.size() <= OutputSize / 2) {
+      const auto end = conn.input.find('\n');
+      if (end == conn.input.size()) {
+        break;
+      }
+
+      conn.input.pop(line_.data(), end + 1);
+      lines++;
+      if (conn.discarding) {
+        conn.discarding = false;
+        continue;
+      }
+
+      std::size_t size = end;
+      if (size > 0 && line_[size - 1] == '\r') {
+        size--;
+      }
+      ring_output output{conn, fd};
+      shell_->execute(conn.session, std::string_view{line_.data(), size},
+                      output);
+    }
+    return lines;
+  }
+
+  /**
+   * @brief Writes the output ring until it is empty or the peer is busy
+   * @return false if the connection failed
+   */
+  static bool send(int fd, connection& conn) {
+    while (!conn.output.empty()) {
+      auto data = conn.output.readable();
+      const auto count =
+          conn.socket ? ::send(fd, data.data(), data.size(), MSG_NOSIGNAL)
+                      : ::write(fd, data.data(), data.size());
+      if (count > 0) {
+        conn.output.consume(static_cast<std::size_t>(count));
+        continue;
+      }
+      if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+      }
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    return true;
+  }
+
+  void close(int fd) {
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+
+    // A descriptor is free again, so listeners taken out of epoll return
+    if (!listening_) {
+      spare_fd_ = open_spare();
+      set_listening(true);
+    }
+  }
+
+  Shell* shell_;
+  int epoll_fd_{-1};
+  int wake_fd_{-1};
+  int spare_fd_{-1};
+  bool listening_{true};
+  bool stopped_{false};
+  std::vector<int> listeners_{};
+  std::unordered_map<int, std::unique_ptr<connection>> connections_{};
+  std::array<char, InputSize> line_{};
+};
+
+}  // namespace shell
+}  // namespace malib
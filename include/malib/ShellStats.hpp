@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string_view>
+#include <utility>
+
+#include "malib/Error.hpp"
+#include "malib/Format.hpp"
+#include "malib/concepts.hpp"
+
+namespace malib {
+namespace shell {
+
+/**
+ * @brief A histogram of latencies in power-of-two nanosecond buckets
+ *
+ * Bucket i counts latencies below 2^i ns and at least 2^(i-1) ns; the last
+ * bucket also takes everything longer. Recording is one relaxed increment,
+ * so any number of threads record into the same histogram without locks.
+ */
+class latency_histogram {
+ public:
+  static constexpr std::size_t buckets = 32;
+
+  void record(std::uint64_t nanoseconds) noexcept {
+    const auto bucket = std::min<std::size_t>(
+        static_cast<std::size_t>(std::bit_width(nanoseconds)), buckets - 1);
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t count(std::size_t bucket) const noexcept {
+    return counts_[bucket].load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns the exclusive upper bound of a bucket in nanoseconds
+   */
+  [[nodiscard]] static constexpr std::uint64_t upper_bound(
+      std::size_t bucket) noexcept {
+    return std::uint64_t{1} << bucket;
+  }
+
+  [[nodiscard]] std::uint64_t total() const noexcept {
+    std::uint64_t sum = 0;
+    for (const auto& counter : counts_) {
+      sum += counter.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  std::array<std::atomic<std::uint64_t>, buckets> counts_{};
+};
+
+/**
+ * @brief Counters and latency histograms of one shell command
+ *
+ * The counters are relaxed atomics: each value is exact, but a reader running
+ * alongside execute() may see a call counted before its error or its bytes.
+ *
+ * Latencies are split into three phases:
+ * - dispatch: finding the command from the first token
+ * - tokenize: splitting the whole line into arguments
+ * - callback: running the command
+ */
+class command_stats {
+ public:
+  static constexpr std::size_t error_codes =
+      static_cast<std::size_t>(Error::QueueFull) + 1;
+
+  latency_histogram dispatch{};
+  latency_histogram tokenize{};
+  latency_histogram callback{};
+
+  /**
+   * @brief Counts a call with its result and the bytes it wrote
+   */
+  void record(Error result, std::size_t bytes) noexcept {
+    calls_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (result != Error::Ok) {
+      const auto code = std::min(static_cast<std::size_t>(result),
+                                 error_codes - 1);
+      errors_[code].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] std::uint64_t calls() const noexcept {
+    return calls_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t output_bytes() const noexcept {
+    return bytes_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Returns how often the command returned the given error
+   */
+  [[nodiscard]] std::uint64_t errors(Error error) const noexcept {
+    const auto code = static_cast<std::size_t>(error);
+    return code < error_codes ? errors_[code].load(std::memory_order_relaxed)
+                              : 0;
+  }
+
+  /**
+   * @brief Returns how often the command failed, with any error
+   */
+  [[nodiscard]] std::uint64_t errors() const noexcept {
+    std::uint64_t sum = 0;
+    for (const auto& counter : errors_) {
+      sum += counter.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Writes the counters as one line, "calls=N errors=N bytes=N\n"
+   */
+  Error write_summary(output_interface auto& output) const {
+    return finish(format_to<"calls={} errors={} bytes={}\n">(
+        output, calls(), errors(), output_bytes()));
+  }
+
+  /**
+   * @brief Writes the summary followed by one line per error code as
+   * "error code count" and one line per phase as "phase bound:count ...",
+   * where bound is the upper bound of a bucket in ns; empty buckets and
+   * errors that never happened are left out
+   */
+  Error write_details(output_interface auto& output) const {
+    auto result = write_summary(output);
+    for (std::size_t code = 1; code < error_codes && result == Error::Ok;
+         ++code) {
+      const auto count = errors(static_cast<Error>(code));
+      if (count != 0) {
+        result = finish(format_to<"error {} {}\n">(output, code, count));
+      }
+    }
+
+    const std::array<std::pair<std::string_view, const latency_histogram*>, 3>
+        phases{{{"dispatch", &dispatch},
+                {"tokenize", &tokenize},
+                {"callback", &callback}}};
+    for (const auto& [name, histogram] : phases) {
+      if (result != Error::Ok) {
+        break;
+      }
+      result = finish(format_to<"{}">(output, name));
+      for (std::size_t i = 0; i < latency_histogram::buckets &&
+                              result == Error::Ok;
+           ++i) {
+        if (const auto count = histogram->count(i); count != 0) {
+          result = finish(format_to<" {}:{}">(
+              output, latency_histogram::upper_bound(i), count));
+        }
+      }
+      if (result == Error::Ok) {
+        result = finish(format_to<"\n">(output));
+      }
+    }
+    return result;
+  }
+
+ private:
+  static Error finish(std::expected<format_result, Error> result) noexcept {
+    if (!result.has_value()) {
+      return result.error();
+    }
+    return result->truncated() ? Error::MaximumSizeExceeded : Error::Ok;
+  }
+
+  std::atomic<std::uint64_t> calls_{0};
+  std::atomic<std::uint64_t> bytes_{0};
+  std::array<std::atomic<std::uint64_t>, error_codes> errors_{};
+};
+
+namespace detail {
+
+/**
+ * @brief Takes the place of command_stats in shells without statistics
+ */
+struct no_stats {};
+
+/**
+ * @brief Measures the time between consecutive lap() calls
+ *
+ * The disabled stopwatch is empty and never reads the clock, so shells
+ * without statistics pay nothing for it.
+ */
+template <bool Enabled>
+class stopwatch {
+ public:
+  std::uint64_t lap() noexcept {
+    const auto now = std::chrono::steady_clock::now();
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_);
+    last_ = now;
+    return static_cast<std::uint64_t>(elapsed.count());
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last_{
+      std::chrono::steady_clock::now()};
+};
+
+template <>
+class stopwatch<false> {
+ public:
+  static constexpr std::uint64_t lap() noexcept { return 0; }
+};
+
+/**
+ * @brief An output that counts the bytes the wrapped output accepted
+ */
+template <typename Output>
+struct counting_output {
+  Output& output;
+  std::size_t bytes{0};
+
+  auto write(const char* data, std::size_t size) {
+    auto result = output.write(data, size);
+    if constexpr (std_expected_any_error<decltype(result), std::size_t>) {
+      bytes += result.value_or(0);
+    } else {
+      bytes += static_cast<std::size_t>(result);
+    }
+    return result;
+  }
+
+  auto write(std::string_view view) { return write(view.data(), view.size()); }
+};
+
+}  // namespace detail
+}  // namespace shell
+}  // namespace malib
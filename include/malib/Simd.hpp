@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Define MALIB_SIMD=0 to force the scalar code paths
+#ifndef MALIB_SIMD
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#define MALIB_SIMD 1
+#else
+#define MALIB_SIMD 0
+#endif
+#endif
+
+#if MALIB_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#endif
+
+namespace malib {
+/**
+ * @brief Building blocks for scanning text 64 bytes at a time
+ *
+ * A block of 64 bytes is classified into 64-bit masks, one bit per byte, with
+ * the widest vector instructions available (AVX2 or SSE2). Scanners then work
+ * on the masks with plain integer operations.
+ */
+namespace simd {
+
+/// Number of bytes described by one mask
+inline constexpr std::size_t BlockSize = 64;
+
+/**
+ * @brief Sets every bit that has an odd number of set bits at or below it
+ *
+ * Applied to a quote mask, this marks the bytes inside quotes.
+ */
+constexpr std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+#if MALIB_SIMD
+#if defined(__AVX2__)
+using vector_type = __m256i;
+inline constexpr std::size_t VectorSize = 32;
+
+inline vector_type load(const char* p) noexcept {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline vector_type match(vector_type v, char c) noexcept {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+inline vector_type either(vector_type a, vector_type b) noexcept {
+  return _mm256_or_si256(a, b);
+}
+
+inline std::uint64_t bits(vector_type v) noexcept {
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(v));
+}
+
+inline vector_type none() noexcept { return _mm256_setzero_si256(); }
+#else
+using vector_type = __m128i;
+inline constexpr std::size_t VectorSize = 16;
+
+inline vector_type load(const char* p) noexcept {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline vector_type match(vector_type v, char c) noexcept {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+inline vector_type either(vector_type a, vector_type b) noexcept {
+  return _mm_or_si128(a, b);
+}
+
+inline std::uint64_t bits(vector_type v) noexcept {
+  return static_cast<std::uint16_t>(_mm_movemask_epi8(v));
+}
+
+inline vector_type none() noexcept { return _mm_setzero_si128(); }
+#endif
+
+/**
+ * @brief Returns the mask of bytes in a 64-byte block equal to c
+ */
+inline std::uint64_t match_block(const char* block, char c) noexcept {
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < BlockSize; i += VectorSize) {
+    mask |= bits(match(load(block + i), c)) << i;
+  }
+  return mask;
+}
+#endif
+
+}  // namespace simd
+}  // namespace malib
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "malib/Error.hpp"
+#include "malib/FixedLengthLinearBuffer.hpp"
+#include "malib/PerfectHash.hpp"
+#include "malib/Shell.hpp"
+#include "malib/TokenRange.hpp"
+#include "malib/concepts.hpp"
+
+namespace malib {
+namespace shell {
+
+/**
+ * @brief A named command for a command_table
+ *
+ * The callable is stored with its own type; it is invoked as
+ * fn(command, args, output) and must return Error.
+ */
+template <typename Fn>
+struct command {
+  std::string_view name;
+  Fn fn;
+};
+
+template <typename Fn>
+command(std::string_view, Fn) -> command<Fn>;
+
+/**
+ * @brief A fixed set of commands whose names are hashed at compile time
+ *
+ * Names go into a PerfectHash, so finding a command is one hash and one
+ * string compare, without allocations or tree walks. The callables are kept
+ * in a tuple and reached through a table of per-command thunks, so calling a
+ * command costs one indirect call and no std::function.
+ *
+ * @code
+ * constexpr malib::shell::command_table commands{
+ *     malib::shell::command{"ping", [](auto, auto, auto& out) {
+ *       return out.write("pong").error_or(malib::Error::Ok);
+ *     }},
+ * };
+ * @endcode
+ */
+template <typename... Fns>
+class command_table {
+  static_assert(sizeof...(Fns) > 0);
+
+ public:
+  consteval explicit command_table(command<Fns>... commands)
+      : names_{commands.name...},
+        callbacks_{commands.fn...},
+        index_{names_} {
+    for (auto name : names_) {
+      if (name.empty()) {
+        malib::detail::consteval_error("Command names must not be empty");
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the index of the command with the given name
+   * @return The index or Error::InvalidCommand
+   */
+  constexpr std::expected<std::size_t, Error> find(
+      std::string_view name) const noexcept {
+    auto index = index_.find(name);
+    if (!index.has_value()) {
+      return std::unexpected(Error::InvalidCommand);
+    }
+    return *index;
+  }
+
+  /**
+   * @brief Calls the command at index, as returned by find()
+   */
+  template <typename OutputBufferType>
+  Error invoke(std::size_t index, std::string_view command, arguments args,
+               OutputBufferType& output) const {
+    static_assert(
+        (std::is_invocable_r_v<Error, const Fns&, std::string_view, arguments,
+                               OutputBufferType&> &&
+         ...),
+        "Commands must be callable as fn(std::string_view, "
+        "shell::arguments, OutputBufferType&) and return Error");
+
+    using thunk = Error (*)(const command_table&, std::string_view, arguments,
+                            OutputBufferType&);
+    static constexpr auto thunks =
+        []<std::size_t... I>(std::index_sequence<I...>) {
+          return std::array<thunk, sizeof...(I)>{
+              +[](const command_table& table, std::string_view command,
+                  arguments args, OutputBufferType& output) {
+                return std::get<I>(table.callbacks_)(command, args, output);
+              }...};
+        }(std::index_sequence_for<Fns...>{});
+    return thunks[index](*this, command, args, output);
+  }
+
+  [[nodiscard]] static constexpr std::size_t size() noexcept {
+    return sizeof...(Fns);
+  }
+
+  [[nodiscard]] constexpr std::string_view name(
+      std::size_t index) const noexcept {
+    return names_[index];
+  }
+
+ private:
+  std::array<std::string_view, sizeof...(Fns)> names_;
+  std::tuple<Fns...> callbacks_;
+  PerfectHash<sizeof...(Fns)> index_;
+};
+
+/**
+ * @brief A shell over a command_table that is fixed at compile time
+ *
+ * Behaves like tiny, but the command set cannot change at run time, which
+ * lets lookups skip the mutable registry entirely.
+ *
+ * @tparam Table A command_table
+ */
+template <typename Table,
+          output_interface OutputBufferType =
+              FixedLengthLinearBuffer<char, ShellFixedLengthLinearBufferSize>,
+          std::size_t MaxTokens = ShellMaxTokensLength>
+class static_tiny {
+ public:
+  using session_type = session<OutputBufferType, MaxTokens>;
+
+  constexpr explicit static_tiny(const Table& table) : table_(table) {}
+
+  /**
+   * @brief Checks if a command exists in the table
+   */
+  bool isCommandValid(std::string_view name) const {
+    return table_.find(name).has_value();
+  }
+
+  /**
+   * @brief Executes a command line and writes the command output to output
+   *
+   * @return Error::Ok, Error::EmptyInput for blank input,
+   * Error::InvalidCommand for unknown commands, tokenizer errors, or the
+   * error returned by the command or the output
+   */
+  Error execute(std::string_view input, output_interface auto& output) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return execute(session_, input, output);
+  }
+
+  /**
+   * @brief Executes a command line using the tokenizer and output buffer of
+   * the given session, without taking any lock
+   */
+  Error execute(session_type& session, std::string_view input,
+                output_interface auto& output) const {
+    auto first = TokenRange<>{input}.begin();
+    if (first == std::default_sentinel) {
+      return Error::EmptyInput;
+    }
+
+    auto command = *first;
+    auto index = table_.find(command);
+    if (!index.has_value()) {
+      output.write(detail::invalid_command_message);
+      return index.error();
+    }
+
+    return session.run(
+        [&](std::string_view name, arguments args, OutputBufferType& buffer) {
+          return table_.invoke(*index, name, args, buffer);
+        },
+        command, input, output);
+  }
+
+  /**
+   * @brief Runs a multi-line script with pipelines, see session::run_script
+   */
+  Error executeScript(std::string_view script, output_interface auto& output,
+                      on_error policy = on_error::stop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return executeScript(session_, script, output, policy);
+  }
+
+  Error executeScript(session_type& session, std::string_view script,
+                      output_interface auto& output,
+                      on_error policy = on_error::stop) const {
+    return session.run_script(
+        script, output, policy,
+        [&](std::string_view line, detail::string_sink& sink) {
+          return execute(session, line, sink);
+        });
+  }
+
+ private:
+  Table table_;
+  session_type session_{};
+  std::mutex mutex_{};
+};
+
+}  // namespace shell
+}  // namespace malib
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <string_view>
+
+#include "malib/CharClasses.hpp"
+#include "malib/Error.hpp"
+
+namespace malib {
+
+/**
+ * @brief Splits a stream of chunks into tokens, one chunk at a time
+ *
+ * Follows the same rules as Tokenizer, but the input does not have to be
+ * contiguous: quote and escape state, as well as a token that is cut off at
+ * the end of a chunk, are carried over to the next call to feed(). Tokens that
+ * lie entirely inside a chunk are passed to the callback as views into that
+ * chunk; only the tail of a token that crosses a chunk boundary is copied into
+ * an internal buffer of MaxTokenLength bytes.
+ *
+ * A view passed to the callback is only valid for the duration of the call.
+ *
+ * @tparam MaxTokenLength Longest token that may span chunk boundaries
+ * @tparam Classes Character classes, see CharClasses.hpp
+ */
+template <std::size_t MaxTokenLength,
+          CharClassTable Classes = char_classes::shell>
+class StreamTokenizer {
+  static_assert(MaxTokenLength > 0);
+
+ public:
+  /**
+   * @brief Tokenizes the next chunk of the stream
+   *
+   * @param chunk The next part of the input
+   * @param on_token Invoked with every token completed by this chunk
+   * @return The number of tokens completed, or Error::MaximumSizeExceeded if
+   * a token spanning chunks is longer than MaxTokenLength. The stream must be
+   * reset() after an error.
+   */
+  template <typename Callback>
+    requires std::invocable<Callback&, std::string_view>
+  std::expected<std::size_t, Error> feed(std::string_view chunk,
+                                         Callback&& on_token) {
+    const auto size = chunk.size();
+    const auto buf = chunk.data();
+    std::size_t pos = 0;
+    std::size_t start = 0;
+    std::size_t completed = 0;
+
+    while (pos < size) {
+      if (!in_token_) {
+        while (pos < size && (Classes[buf[pos]] & Separator)) {
+          pos++;
+        }
+
+        if (pos == size) {
+          break;
+        }
+
+        start = pos;
+        in_token_ = true;
+      }
+
+      pos = scan(chunk, pos);
+      if (pos == size) {
+        break;
+      }
+
+      in_token_ = false;
+      if (auto err = complete(chunk.substr(start, pos - start), on_token);
+          err != Error::Ok) {
+        return std::unexpected(err);
+      }
+      completed++;
+    }
+
+    if (in_token_) {
+      if (auto err = carry(chunk.substr(start)); err != Error::Ok) {
+        return std::unexpected(err);
+      }
+    }
+
+    return completed;
+  }
+
+  /**
+   * @brief Ends the stream, completing the token still in progress
+   *
+   * @return The number of tokens completed (0 or 1)
+   */
+  template <typename Callback>
+    requires std::invocable<Callback&, std::string_view>
+  std::size_t finish(Callback&& on_token) {
+    const bool pending = in_token_;
+    if (pending) {
+      on_token(std::string_view(carry_.data(), carry_size_));
+    }
+    reset();
+    return pending ? 1 : 0;
+  }
+
+  /**
+   * @brief Discards the partial token and all carried state
+   */
+  void reset() noexcept {
+    carry_size_ = 0;
+    in_token_ = false;
+    quoted_ = false;
+    escaped_ = false;
+  }
+
+  /**
+   * @brief Returns the number of bytes of the token in progress
+   */
+  [[nodiscard]] std::size_t pending() const noexcept { return carry_size_; }
+
+  /**
+   * @brief Checks whether the stream currently ends inside quotes
+   */
+  [[nodiscard]] bool quoted() const noexcept { return quoted_; }
+
+ private:
+  static constexpr auto Separator =
+      static_cast<std::uint8_t>(CharClass::Separator);
+  static constexpr auto Quote = static_cast<std::uint8_t>(CharClass::Quote);
+  static constexpr auto Escape = static_cast<std::uint8_t>(CharClass::Escape);
+  static constexpr bool HasEscapes =
+      Classes.members(CharClass::Escape).size > 0;
+
+  /**
+   * @brief Advances over the current token
+   * @return The position of the separator ending the token, or the chunk size
+   */
+  std::size_t scan(std::string_view chunk, std::size_t pos) noexcept {
+    const auto size = chunk.size();
+    const auto buf = chunk.data();
+    while (pos < size) {
+      const auto cls = Classes[buf[pos]];
+      if constexpr (HasEscapes) {
+        if (escaped_) {
+          escaped_ = false;
+          pos++;
+          continue;
+        }
+
+        if (cls & Escape) {
+          escaped_ = true;
+          pos++;
+          continue;
+        }
+      }
+
+      if (cls & Quote) {
+        quoted_ = !quoted_;
+      }
+
+      if ((cls & Separator) && !quoted_) {
+        break;
+      }
+      pos++;
+    }
+    return pos;
+  }
+
+  Error carry(std::string_view piece) noexcept {
+    if (piece.size() > MaxTokenLength - carry_size_) {
+      return Error::MaximumSizeExceeded;
+    }
+    std::memcpy(carry_.data() + carry_size_, piece.data(), piece.size());
+    carry_size_ += piece.size();
+    return Error::Ok;
+  }
+
+  template <typename Callback>
+  Error complete(std::string_view piece, Callback& on_token) {
+    if (carry_size_ == 0) {
+      on_token(piece);
+      return Error::Ok;
+    }
+
+    if (auto err = carry(piece); err != Error::Ok) {
+      return err;
+    }
+    on_token(std::string_view(carry_.data(), carry_size_));
+    carry_size_ = 0;
+    return Error::Ok;
+  }
+
+  std::array<char, MaxTokenLength> carry_{};
+  std::size_t carry_size_{0};
+  bool in_token_{false};
+  bool quoted_{false};
+  bool escaped_{false};
+};
+
+}  // namespace malib
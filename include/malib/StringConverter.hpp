@@ -1,9 +1,14 @@
 #pragma once
 
+#include <array>
+#include <algorithm>
+#include <cerrno>
 #include <charconv>
 #include <cmath>
 #include <concepts>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -11,43 +16,378 @@
 #include "malib/Token.hpp"
 
 namespace malib {
+/**
+ * @brief Converts strings to numbers without allocating
+ *
+ * Every conversion is constexpr, so constant configuration strings can be
+ * parsed and validated at compile time. At run time std::from_chars does the
+ * work; during constant evaluation an equivalent parser is used instead.
+ * Standard libraries without floating point std::from_chars (libc++ before
+ * LLVM 20) parse floating point numbers with strtod on a stack copy.
+ */
 struct StringConverter {  // Changed from TokenReader
-  static Error to_number(std::string_view input, std::integral auto& value,
-                         int radix = 10) {
-    auto [ptr, ec] = std::from_chars(input.data(), input.data() + input.size(),
-                                     value, radix);
+  /**
+   * @brief Parses an integer in the given radix
+   *
+   * Follows std::from_chars: an optional '-' for signed types, then at least
+   * one digit; parsing stops at the first character that is not a digit.
+   *
+   * @return Error::Ok, Error::InvalidArgument if there is no number, or
+   * Error::ResultOutOfRange if it does not fit in value
+   */
+  static constexpr Error to_number(std::string_view input,
+                                   std::integral auto& value,
+                                   int radix = 10) {
+    std::size_t used = 0;
+    return convert(input, value, radix, used);
+  }
+
+  /**
+   * @brief Parses a floating point number
+   *
+   * Leading whitespace and a '+' sign are skipped like strtod does; the rest
+   * follows std::from_chars in general format, including "inf" and "nan".
+   * Hexadecimal floats are not accepted.
+   *
+   * During constant evaluation the result is correctly rounded for up to 15
+   * significant digits and decimal exponents within +-22, which covers
+   * ordinary configuration values; other inputs may differ from the run time
+   * result in the last bit.
+   *
+   * @return Error::Ok, Error::InvalidArgument if there is no number, or
+   * Error::ResultOutOfRange if it overflows or underflows value
+   */
+  static constexpr Error to_number(std::string_view input,
+                                   std::floating_point auto& value) {
+    std::size_t used = 0;
+    return convert(input, value, used);
+  }
+
+  /**
+   * @brief Parses a number that must span the whole input
+   *
+   * Accepts what to_number accepts, but a number followed by anything else,
+   * such as "5abc" or "2.9" for an integer, is Error::InvalidArgument instead
+   * of a parsed prefix. Use it where the input is a single value, e.g. a
+   * command argument or an option value.
+   *
+   * @return Error::Ok, Error::InvalidArgument if the input is not exactly one
+   * number, or Error::ResultOutOfRange if it does not fit in value
+   */
+  static constexpr Error to_number_exact(std::string_view input,
+                                         std::integral auto& value,
+                                         int radix = 10) {
+    std::size_t used = 0;
+    const auto result = convert(input, value, radix, used);
+    return result == Error::Ok && used != input.size() ? Error::InvalidArgument
+                                                       : result;
+  }
+
+  static constexpr Error to_number_exact(std::string_view input,
+                                         std::floating_point auto& value) {
+    std::size_t used = 0;
+    const auto result = convert(input, value, used);
+    return result == Error::Ok && used != input.size() ? Error::InvalidArgument
+                                                       : result;
+  }
+
+ private:
+  /**
+   * @brief Parses an integer and sets used to the number of characters it
+   * took, which is only meaningful on success
+   */
+  template <std::integral T>
+  static constexpr Error convert(std::string_view input, T& value, int radix,
+                                 std::size_t& used) {
+    if consteval {
+      return parse_integer(input, value, radix, used);
+    } else {
+      auto [ptr, ec] = std::from_chars(
+          input.data(), input.data() + input.size(), value, radix);
+
+      if (ec == std::errc::invalid_argument) {
+        return Error::InvalidArgument;
+      } else if (ec == std::errc::result_out_of_range) {
+        return Error::ResultOutOfRange;
+      }
+
+      used = static_cast<std::size_t>(ptr - input.data());
+      return Error::Ok;
+    }
+  }
+
+  template <std::floating_point T>
+  static constexpr Error convert(std::string_view input, T& value,
+                                 std::size_t& used) {
+    std::size_t pos = 0;
+    while (pos < input.size() && is_space(input[pos])) {
+      pos++;
+    }
+    if (pos + 1 < input.size() && input[pos] == '+' && input[pos + 1] != '-') {
+      pos++;
+    }
+    input.remove_prefix(pos);
+
+    if consteval {
+      const auto result = parse_floating(input, value, used);
+      used += pos;
+      return result;
+    } else {
+#if defined(__cpp_lib_to_chars)
+      auto [ptr, ec] =
+          std::from_chars(input.data(), input.data() + input.size(), value);
 
-    if (ec == std::errc::invalid_argument) {
+      if (ec == std::errc::invalid_argument) {
+        return Error::InvalidArgument;
+      } else if (ec == std::errc::result_out_of_range) {
+        return Error::ResultOutOfRange;
+      }
+
+      used = pos + static_cast<std::size_t>(ptr - input.data());
+      return Error::Ok;
+#else
+      const auto result = parse_with_strtod(input, value, used);
+      used += pos;
+      return result;
+#endif
+    }
+  }
+
+  /**
+   * @brief Parses a floating point number with strtod, strtof or strtold
+   *
+   * The input is copied to a NUL-terminated stack buffer. strtod also skips
+   * whitespace and reads hexadecimal floats, which std::from_chars does not,
+   * so those inputs and ones too long for the buffer go to parse_floating.
+   */
+  template <std::floating_point T>
+  static Error parse_with_strtod(std::string_view input, T& value,
+                                 std::size_t& used) {
+    if (!input.empty() && is_space(input.front())) {
       return Error::InvalidArgument;
-    } else if (ec == std::errc::result_out_of_range) {
-      return Error::ResultOutOfRange;
+    }
+    const std::size_t sign = !input.empty() && input.front() == '-' ? 1 : 0;
+    const bool hex = input.size() > sign + 1 && input[sign] == '0' &&
+                     (input[sign + 1] | 0x20) == 'x';
+    std::array<char, 64> copy{};
+    if (hex || input.size() >= copy.size()) {
+      return parse_floating(input, value, used);
+    }
+    std::copy(input.begin(), input.end(), copy.begin());
+
+    char* end = nullptr;
+    errno = 0;
+    T result{};
+    if constexpr (std::same_as<T, float>) {
+      result = std::strtof(copy.data(), &end);
+    } else if constexpr (std::same_as<T, double>) {
+      result = std::strtod(copy.data(), &end);
+    } else {
+      result = std::strtold(copy.data(), &end);
     }
 
+    if (end == copy.data()) {
+      return Error::InvalidArgument;
+    }
+    if (errno == ERANGE) {
+      return Error::ResultOutOfRange;
+    }
+    value = result;
+    used = static_cast<std::size_t>(end - copy.data());
     return Error::Ok;
   }
 
-  static Error to_number(std::string_view input,
-                         std::floating_point auto& value) {
-    std::string input_str{input.data(), input.size()};
-    char* end = nullptr;
+  static constexpr bool is_space(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+  }
 
-    if constexpr (std::is_same_v<std::decay_t<decltype(value)>, float>) {
-      value = std::strtof(input_str.c_str(), &end);
+  static constexpr int digit_value(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'z') {
+      return c - 'a' + 10;
     }
+    if (c >= 'A' && c <= 'Z') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  template <std::integral T>
+  static constexpr Error parse_integer(std::string_view input, T& value,
+                                       int radix, std::size_t& used) {
+    using unsigned_type = std::make_unsigned_t<T>;
 
-    if constexpr (std::is_same_v<std::decay_t<decltype(value)>, double>) {
-      value = std::strtod(input_str.c_str(), &end);
+    std::size_t pos = 0;
+    bool negative = false;
+    if constexpr (std::is_signed_v<T>) {
+      if (pos < input.size() && input[pos] == '-') {
+        negative = true;
+        pos++;
+      }
     }
 
-    if constexpr (std::is_same_v<std::decay_t<decltype(value)>, long double>) {
-      value = std::strtold(input_str.c_str(), &end);
+    const auto limit =
+        static_cast<unsigned_type>(std::numeric_limits<T>::max()) +
+        (negative ? 1u : 0u);
+    const auto start = pos;
+    unsigned_type result = 0;
+    bool overflow = false;
+    for (; pos < input.size(); ++pos) {
+      const int digit = digit_value(input[pos]);
+      if (digit < 0 || digit >= radix) {
+        break;
+      }
+      if (result > (limit - static_cast<unsigned_type>(digit)) /
+                       static_cast<unsigned_type>(radix)) {
+        overflow = true;
+      } else {
+        result = static_cast<unsigned_type>(result * radix + digit);
+      }
     }
 
-    if (end == input_str.c_str()) {
+    if (pos == start) {
       return Error::InvalidArgument;
     }
+    if (overflow) {
+      return Error::ResultOutOfRange;
+    }
+
+    value = negative ? static_cast<T>(unsigned_type{0} - result)
+                     : static_cast<T>(result);
+    used = pos;
+    return Error::Ok;
+  }
+
+  template <std::floating_point T>
+  static constexpr Error parse_floating(std::string_view input, T& value,
+                                        std::size_t& used) {
+    std::size_t pos = 0;
+    bool negative = false;
+    if (pos < input.size() && input[pos] == '-') {
+      negative = true;
+      pos++;
+    }
+
+    auto matches = [&](std::string_view word) {
+      if (input.size() - pos < word.size()) {
+        return false;
+      }
+      for (std::size_t i = 0; i < word.size(); ++i) {
+        if ((input[pos + i] | 0x20) != word[i]) {
+          return false;
+        }
+      }
+      return true;
+    };
+    if (matches("inf")) {
+      value = negative ? -std::numeric_limits<T>::infinity()
+                       : std::numeric_limits<T>::infinity();
+      used = pos + (matches("infinity") ? 8 : 3);
+      return Error::Ok;
+    }
+    if (matches("nan")) {
+      value = std::numeric_limits<T>::quiet_NaN();
+      used = pos + 3;
+      return Error::Ok;
+    }
+
+    // Up to 19 significant digits are kept in the mantissa; the rest only
+    // shift the decimal exponent
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    bool fraction = false;
+    for (; pos < input.size(); ++pos) {
+      const char c = input[pos];
+      if (c == '.' && !fraction) {
+        fraction = true;
+        continue;
+      }
+      if (c < '0' || c > '9') {
+        break;
+      }
+      any_digit = true;
+      if (mantissa == 0 && c == '0') {
+        exponent -= fraction ? 1 : 0;
+        continue;
+      }
+      if (digits < 19) {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(c - '0');
+        digits++;
+        exponent -= fraction ? 1 : 0;
+      } else {
+        exponent += fraction ? 0 : 1;
+      }
+    }
+
+    if (!any_digit) {
+      return Error::InvalidArgument;
+    }
+
+    if (pos < input.size() && (input[pos] | 0x20) == 'e') {
+      std::size_t exp_pos = pos + 1;
+      bool exp_negative = false;
+      if (exp_pos < input.size() &&
+          (input[exp_pos] == '-' || input[exp_pos] == '+')) {
+        exp_negative = input[exp_pos] == '-';
+        exp_pos++;
+      }
+      int exp_value = 0;
+      const auto exp_start = exp_pos;
+      while (exp_pos < input.size() && input[exp_pos] >= '0' &&
+             input[exp_pos] <= '9') {
+        if (exp_value < 100000) {
+          exp_value = exp_value * 10 + (input[exp_pos] - '0');
+        }
+        exp_pos++;
+      }
+      // Like from_chars, an exponent without digits is not part of the number
+      if (exp_pos > exp_start) {
+        exponent += exp_negative ? -exp_value : exp_value;
+        pos = exp_pos;
+      }
+    }
+
+    long double result = static_cast<long double>(mantissa);
+    if (mantissa != 0) {
+      constexpr std::array<double, 23> exact_powers{
+          1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+          1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+          1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+      if (mantissa <= (std::uint64_t{1} << 53) && exponent >= -22 &&
+          exponent <= 22) {
+        // Both operands are exact, so a single rounding step remains
+        const double exact = static_cast<double>(mantissa);
+        result = exponent < 0 ? exact / exact_powers[-exponent]
+                              : exact * exact_powers[exponent];
+      } else {
+        for (; exponent > 0; --exponent) {
+          result *= 10;
+          if (result > std::numeric_limits<T>::max()) {
+            return Error::ResultOutOfRange;
+          }
+        }
+        for (; exponent < 0; ++exponent) {
+          result /= 10;
+          if (result == 0) {
+            return Error::ResultOutOfRange;
+          }
+        }
+      }
+
+      if (result > std::numeric_limits<T>::max() ||
+          result < std::numeric_limits<T>::denorm_min()) {
+        return Error::ResultOutOfRange;
+      }
+    }
 
+    value = static_cast<T>(negative ? -result : result);
+    used = pos;
     return Error::Ok;
   }
 };
-}  // namespace malib
\ No newline at end of file
+}  // namespace malib
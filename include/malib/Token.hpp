@@ -5,24 +5,51 @@
 #include <expected>
 #include <span>
 #include <string_view>
+#include <type_traits>
 
 #include "malib/Error.hpp"
 
 namespace malib {
 
 /**
- * @struct Token
+ * @struct BasicToken
  * @brief Represents a token with an offset and length.
  *
- * The Token struct is used to represent a substring within a larger string.
- * It contains an offset and length, both packed into a 32-bit integer.
- * It must not overlap with other token and must be within the bounds of the
- * base string.
+ * The BasicToken struct is used to represent a substring within a larger
+ * string. It contains an offset and length packed into a single integer of
+ * OffsetBits + LengthBits bits. It must not overlap with other token and must
+ * be within the bounds of the base string.
+ *
+ * @tparam OffsetBits Number of bits used for the offset
+ * @tparam LengthBits Number of bits used for the length
  */
-struct Token {
-  uint32_t offset : 24;  ///< The offset of the token within the base string (24
-                         ///< bits).
-  uint32_t length : 8;   ///< The length of the token (8 bits).
+template <std::size_t OffsetBits, std::size_t LengthBits>
+struct BasicToken {
+  static_assert(OffsetBits > 0 && LengthBits > 0);
+  static_assert(OffsetBits + LengthBits <= 64,
+                "Token fields must fit in 64 bits");
+
+  using storage_type =
+      std::conditional_t<(OffsetBits + LengthBits <= 32), uint32_t, uint64_t>;
+
+  /// Largest offset the token can represent
+  static constexpr std::size_t max_offset =
+      static_cast<std::size_t>((uint64_t{1} << OffsetBits) - 1);
+  /// Largest length the token can represent
+  static constexpr std::size_t max_length =
+      static_cast<std::size_t>((uint64_t{1} << LengthBits) - 1);
+
+  storage_type offset : OffsetBits;  ///< The offset of the token within the
+                                     ///< base string.
+  storage_type length : LengthBits;  ///< The length of the token.
+
+  /**
+   * @brief Checks whether an offset/length pair can be stored without
+   * truncation.
+   */
+  static constexpr bool fits(std::size_t offset, std::size_t length) noexcept {
+    return offset <= max_offset && length <= max_length;
+  }
 
   /**
    * @brief Returns a view of the token within the base string.
@@ -30,7 +57,7 @@ struct Token {
    * @param base The base string from which the token is derived.
    * @return A std::string_view representing the token.
    */
-  std::string_view view(std::string_view base) const noexcept {
+  constexpr std::string_view view(std::string_view base) const noexcept {
     return base.substr(offset, length);
   }
 
@@ -39,30 +66,37 @@ struct Token {
    *
    * @return true if the token length is 0, false otherwise.
    */
-  bool empty() const noexcept { return length == 0; }
+  constexpr bool empty() const noexcept { return length == 0; }
 };
 
+/// The default token: 24 bit offset and 8 bit length in 4 bytes
+using Token = BasicToken<24, 8>;
+/// A token for large inputs: 32 bit offset and 32 bit length in 8 bytes
+using WideToken = BasicToken<32, 32>;
+
 static_assert(sizeof(Token) == 4, "Token should be 4 bytes");
+static_assert(sizeof(WideToken) == 8, "WideToken should be 8 bytes");
 
 /**
- * @struct TokenViews
+ * @struct BasicTokenViews
  * @brief A view container that provides access to a sequence of tokens within a
  * base string.
  *
- * @warning The base string and tokens span must outlive any TokenViews
+ * @warning The base string and tokens span must outlive any BasicTokenViews
  * instances and their iterators that reference them.
  * @warning All tokens must have valid offset and length values within the
  * bounds of the base string.
  *
- * TokenViews provides a convenient way to iterate over and access token
+ * BasicTokenViews provides a convenient way to iterate over and access token
  * contents from a base string. It holds a reference to the base string and a
  * span of Token objects, allowing efficient access to token substrings without
  * copying data.
  */
-struct TokenViews {
+template <typename TokenType>
+struct BasicTokenViews {
   /**
    * @struct TokenIterator
-   * @brief Iterator for traversing token contents within a TokenViews
+   * @brief Iterator for traversing token contents within a BasicTokenViews
    * container.
    *
    * Provides standard iterator interface for accessing token contents directly
@@ -70,27 +104,29 @@ struct TokenViews {
    */
   struct TokenIterator {
     std::string_view base;  ///< Reference to the base string
-    std::span<const Token>::iterator
+    typename std::span<const TokenType>::iterator
         current;  ///< Current position in the token span
 
-    std::string_view operator*() const noexcept { return current->view(base); }
+    constexpr std::string_view operator*() const noexcept {
+      return current->view(base);
+    }
 
-    TokenIterator& operator++() noexcept {
+    constexpr TokenIterator& operator++() noexcept {
       ++current;
       return *this;
     }
 
-    TokenIterator operator++(int) noexcept {
+    constexpr TokenIterator operator++(int) noexcept {
       TokenIterator tmp = *this;
       ++current;
       return tmp;
     }
 
-    bool operator!=(const TokenIterator& other) const noexcept {
+    constexpr bool operator!=(const TokenIterator& other) const noexcept {
       return current != other.current;
     }
 
-    bool operator==(const TokenIterator& other) const noexcept {
+    constexpr bool operator==(const TokenIterator& other) const noexcept {
       return current == other.current;
     }
   };
@@ -99,25 +135,29 @@ struct TokenViews {
    * @brief Returns an iterator to the beginning of the token sequence.
    * @return TokenIterator pointing to the first token.
    */
-  TokenIterator begin() const { return TokenIterator{base, tokens.begin()}; }
+  constexpr TokenIterator begin() const {
+    return TokenIterator{base, tokens.begin()};
+  }
 
   /**
    * @brief Returns an iterator to the end of the token sequence.
    * @return TokenIterator pointing past the last token.
    */
-  TokenIterator end() const { return TokenIterator{base, tokens.end()}; }
+  constexpr TokenIterator end() const {
+    return TokenIterator{base, tokens.end()};
+  }
 
   /**
    * @brief Returns the number of tokens in the sequence.
    * @return Size of the token sequence.
    */
-  std::size_t size() const noexcept { return tokens.size(); }
+  constexpr std::size_t size() const noexcept { return tokens.size(); }
 
   /**
    * @brief Checks if the token sequence is empty.
    * @return true if there are no tokens, false otherwise.
    */
-  bool empty() const noexcept { return tokens.empty(); }
+  constexpr bool empty() const noexcept { return tokens.empty(); }
 
   /**
    * @brief Accesses a token's contents by index.
@@ -125,7 +165,7 @@ struct TokenViews {
    * @return Expected containing the token's contents as string_view if idx is
    * valid, or Error::IndexOutOfRange if idx is out of bounds.
    */
-  std::expected<std::string_view, Error> operator[](
+  constexpr std::expected<std::string_view, Error> operator[](
       std::size_t idx) const noexcept {
     if (idx >= tokens.size()) {
       return std::unexpected{Error::IndexOutOfRange};
@@ -134,28 +174,30 @@ struct TokenViews {
   }
 
   /**
-   * @brief Creates a TokenViews instance.
+   * @brief Creates a BasicTokenViews instance.
    *
    * @param base The base string being referenced.
    * @param tokens A span of Token objects representing the tokens.
-   * @return std::expected<TokenViews, Error>
+   * @return std::expected<BasicTokenViews, Error>
    */
-  static std::expected<TokenViews, Error> create(
-      std::string_view base, std::span<const Token> tokens) noexcept {
-    uint32_t last_end = 0;
-    for (const Token& token : tokens) {
+  static constexpr std::expected<BasicTokenViews, Error> create(
+      std::string_view base, std::span<const TokenType> tokens) noexcept {
+    std::size_t last_end = 0;
+    for (const TokenType& token : tokens) {
+      const std::size_t offset = token.offset;
+      const std::size_t length = token.length;
       // Check if token is within bounds
-      if (token.offset + token.length > base.size()) {
+      if (offset + length > base.size()) {
         return std::unexpected{Error::IndexOutOfRange};
       }
       // Check if tokens are ordered and non-overlapping
-      if (token.offset < last_end) {
+      if (offset < last_end) {
         return std::unexpected{Error::InvalidArgument};
       }
-      last_end = token.offset + token.length;
+      last_end = offset + length;
     }
 
-    return TokenViews{base, tokens};
+    return BasicTokenViews{base, tokens};
   }
 
   /**
@@ -164,7 +206,7 @@ struct TokenViews {
    * @return Expected containing the token's contents as string_view if idx is
    * valid, or Error::IndexOutOfRange if idx is out of bounds.
    */
-  std::expected<std::string_view, Error> safe_access(
+  constexpr std::expected<std::string_view, Error> safe_access(
       std::size_t idx) const noexcept {
     if (idx >= tokens.size()) {
       return std::unexpected{Error::IndexOutOfRange};
@@ -173,11 +215,15 @@ struct TokenViews {
   }
 
  private:
-  TokenViews(std::string_view base, std::span<const Token> tokens)
+  constexpr BasicTokenViews(std::string_view base,
+                            std::span<const TokenType> tokens)
       : base(base), tokens(tokens) {}
 
   std::string_view base;  ///< The base string containing the token contents
-  std::span<const Token> tokens;  ///< Span of tokens representing substrings
-                                  ///< within the base string
+  std::span<const TokenType> tokens;  ///< Span of tokens representing
+                                      ///< substrings within the base string
 };
+
+using TokenViews = BasicTokenViews<Token>;
+using WideTokenViews = BasicTokenViews<WideToken>;
 }  // namespace malib
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string_view>
+
+#include "malib/CharClasses.hpp"
+#include "malib/Error.hpp"
+
+namespace malib {
+
+/**
+ * @brief Strips quotes and resolves escapes in a token
+ *
+ * Interprets a token with the same rules the Tokenizer used to find it: every
+ * unescaped quote character is removed, and an escape character is removed
+ * while the character after it is kept literally. An escape character at the
+ * very end of the token has nothing to escape and is kept.
+ *
+ * Tokens that need no rewriting are returned as views into the input: tokens
+ * without quote or escape characters as they are, and tokens that are only
+ * wrapped in a pair of quotes as the part between them. Anything else is
+ * decoded into a caller-supplied arena.
+ *
+ * @tparam Classes Character classes, see CharClasses.hpp
+ */
+template <CharClassTable Classes = char_classes::shell_escaped>
+struct TokenDecoder {
+  /**
+   * @brief Returns the number of bytes the decoded token occupies
+   */
+  static constexpr std::size_t decoded_size(std::string_view token) noexcept {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < token.size(); ++i) {
+      const auto cls = Classes[token[i]];
+      if ((cls & Escape) && i + 1 < token.size()) {
+        size++;
+        i++;
+      } else if (!(cls & Quote)) {
+        size++;
+      }
+    }
+    return size;
+  }
+
+  /**
+   * @brief Returns the contents of the token if it can be decoded without
+   * copying
+   *
+   * @return A view into token, or Error::InvalidArgument if the token has to
+   * be rewritten
+   */
+  static constexpr std::expected<std::string_view, Error> view(
+      std::string_view token) noexcept {
+    const auto first_special = find_special(token, 0);
+    if (first_special == token.size()) {
+      return token;
+    }
+
+    // A single pair of quotes around the whole token
+    if (first_special == 0 && token.size() >= 2 &&
+        token.front() == token.back() && (Classes[token.front()] & Quote) &&
+        find_special(token, 1) == token.size() - 1) {
+      return token.substr(1, token.size() - 2);
+    }
+
+    return std::unexpected(Error::InvalidArgument);
+  }
+
+  /**
+   * @brief Decodes a token, copying only when the token has to be rewritten
+   *
+   * @param token The token as found by the Tokenizer
+   * @param arena Storage for rewritten tokens; the bytes used are removed from
+   * its front, so one arena can hold many decoded tokens
+   * @return The decoded token, or Error::BufferFull if the arena is too small
+   */
+  static constexpr std::expected<std::string_view, Error> decode(
+      std::string_view token, std::span<char>& arena) noexcept {
+    if (auto direct = view(token); direct.has_value()) {
+      return direct;
+    }
+
+    const auto size = decoded_size(token);
+    if (size > arena.size()) {
+      return std::unexpected(Error::BufferFull);
+    }
+
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < token.size(); ++i) {
+      const auto cls = Classes[token[i]];
+      if ((cls & Escape) && i + 1 < token.size()) {
+        arena[out++] = token[++i];
+      } else if (!(cls & Quote)) {
+        arena[out++] = token[i];
+      }
+    }
+
+    std::string_view result(arena.data(), size);
+    arena = arena.subspan(size);
+    return result;
+  }
+
+ private:
+  static constexpr auto Quote = static_cast<std::uint8_t>(CharClass::Quote);
+  static constexpr auto Escape = static_cast<std::uint8_t>(CharClass::Escape);
+
+  static constexpr std::size_t find_special(std::string_view token,
+                                            std::size_t pos) noexcept {
+    while (pos < token.size() && !(Classes[token[pos]] & (Quote | Escape))) {
+      pos++;
+    }
+    return pos;
+  }
+};
+
+}  // namespace malib
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+
+#include "malib/CharClasses.hpp"
+
+namespace malib {
+
+/**
+ * @brief A lazy view over the tokens of a string
+ *
+ * Follows the same rules as Tokenizer, but finds each token only when the
+ * iterator reaches it. Nothing is stored besides the input view and the
+ * position of the current token, so there is no limit on the number of tokens
+ * and a consumer that stops early, e.g. to look at the command name only,
+ * never scans the rest of the input.
+ *
+ * The input must outlive the range and every token obtained from it.
+ *
+ * @tparam Classes Character classes, see CharClasses.hpp
+ */
+template <CharClassTable Classes = char_classes::shell>
+class TokenRange : public std::ranges::view_interface<TokenRange<Classes>> {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+    constexpr iterator() noexcept = default;
+
+    constexpr explicit iterator(std::string_view input) noexcept
+        : input_(input) {
+      advance(0);
+    }
+
+    constexpr std::string_view operator*() const noexcept {
+      return input_.substr(start_, end_ - start_);
+    }
+
+    constexpr iterator& operator++() noexcept {
+      advance(end_);
+      return *this;
+    }
+
+    constexpr iterator operator++(int) noexcept {
+      iterator tmp = *this;
+      advance(end_);
+      return tmp;
+    }
+
+    constexpr bool operator==(const iterator& other) const noexcept {
+      return start_ == other.start_ && input_.data() == other.input_.data();
+    }
+
+    constexpr bool operator==(std::default_sentinel_t) const noexcept {
+      return start_ == input_.size();
+    }
+
+   private:
+    static constexpr auto Separator =
+        static_cast<std::uint8_t>(CharClass::Separator);
+    static constexpr auto Quote = static_cast<std::uint8_t>(CharClass::Quote);
+    static constexpr auto Escape = static_cast<std::uint8_t>(CharClass::Escape);
+
+    /**
+     * @brief Finds the token starting at or after pos
+     */
+    constexpr void advance(std::size_t pos) noexcept {
+      const auto size = input_.size();
+      while (pos < size && (Classes[input_[pos]] & Separator)) {
+        pos++;
+      }
+
+      start_ = pos;
+      bool quoted = false;
+      bool escaped = false;
+      while (pos < size) {
+        const auto cls = Classes[input_[pos]];
+        if (escaped) {
+          escaped = false;
+        } else if (cls & Escape) {
+          escaped = true;
+        } else {
+          if (cls & Quote) {
+            quoted = !quoted;
+          }
+          if ((cls & Separator) && !quoted) {
+            break;
+          }
+        }
+        pos++;
+      }
+      end_ = pos;
+    }
+
+    std::string_view input_{};
+    std::size_t start_{0};
+    std::size_t end_{0};
+  };
+
+  constexpr TokenRange() noexcept = default;
+  constexpr explicit TokenRange(std::string_view input) noexcept
+      : input_(input) {}
+
+  constexpr iterator begin() const noexcept { return iterator{input_}; }
+
+  constexpr std::default_sentinel_t end() const noexcept {
+    return std::default_sentinel;
+  }
+
+ private:
+  std::string_view input_{};
+};
+
+static_assert(std::ranges::view<TokenRange<>>);
+static_assert(std::ranges::forward_range<TokenRange<>>);
+}  // namespace malib
@@ -1,85 +1,356 @@
 #pragma once
 
 #include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <expected>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "malib/CharClasses.hpp"
 #include "malib/Error.hpp"
+#include "malib/Simd.hpp"
 #include "malib/Token.hpp"
+#include "malib/TokenDecoder.hpp"
+
+// Define MALIB_TOKENIZER_SIMD=0 to force the scalar tokenizer
+#ifndef MALIB_TOKENIZER_SIMD
+#define MALIB_TOKENIZER_SIMD MALIB_SIMD
+#endif
 
 namespace malib {
-template <std::size_t MaxTokens>
+
+/**
+ * @brief Splits a string into tokens using a compile-time character table
+ *
+ * Runs of separator characters split tokens, separators inside quotes do not,
+ * and an escape character strips the special meaning from the character that
+ * follows it. Quote and escape characters are kept in the token. Tokens are
+ * stored as offset/length pairs into the input, so the input must outlive the
+ * tokens.
+ *
+ * On targets with SSE2 or AVX2 the input is classified 64 bytes at a time:
+ * each character class becomes a bitmask, escaped characters are found with
+ * carry propagation over the escape mask, quoted regions are resolved with a
+ * prefix-XOR over the quote mask, and token boundaries are extracted from the
+ * resulting masks. Other targets use an equivalent scalar loop with one table
+ * lookup per byte, as does constant evaluation: tokenize() is constexpr, so
+ * constant command lines can be split at compile time.
+ *
+ * Offsets and lengths that do not fit in TokenType are reported as
+ * Error::ResultOutOfRange instead of being truncated. Use WideToken (see
+ * WideTokenizer) for inputs beyond 16 MB or tokens longer than 255 bytes.
+ *
+ * @tparam MaxTokens Maximum number of tokens a single input may contain
+ * @tparam Classes Character classes, see CharClasses.hpp
+ * @tparam TokenType The token representation, see BasicToken
+ */
+template <std::size_t MaxTokens,
+          CharClassTable Classes = char_classes::shell,
+          typename TokenType = Token>
 class Tokenizer {
  public:
-  std::expected<std::size_t, Error> tokenize(std::string_view str) {
+  using token_type = TokenType;
+
+  constexpr std::expected<std::size_t, Error> tokenize(std::string_view str) {
     count_ = 0;
+    auto err = scan(str, [this](std::size_t offset, std::size_t length) {
+      return emit(offset, length);
+    });
+    if (err != Error::Ok) {
+      return std::unexpected(err);
+    }
+    return count_;
+  }
+
+  /**
+   * @brief Finds the tokens of a string without storing them
+   *
+   * @param str The input string
+   * @param on_token Called with the offset and length of every token, in
+   * order; returning anything but Error::Ok stops the scan
+   * @return Error::Ok, or the error returned by on_token
+   */
+  template <typename Callback>
+    requires std::is_invocable_r_v<Error, Callback&, std::size_t, std::size_t>
+  static constexpr Error scan(std::string_view str, Callback&& on_token) {
+#if MALIB_TOKENIZER_SIMD
+    if !consteval {
+      return scan_blocks(str, on_token);
+    }
+#endif
+    return scan_scalar(str, on_token);
+  }
+
+  constexpr std::expected<TokenType, Error> operator[](
+      std::size_t idx) const noexcept {
+    if (idx >= MaxTokens || idx >= count_) {
+      return std::unexpected(Error::IndexOutOfRange);
+    }
+    return markers_[idx];
+  }
+
+  constexpr std::span<const TokenType> tokens_span() const noexcept {
+    return std::span<const TokenType>(markers_.data(), count_);
+  }
+
+  constexpr auto tokens_views(std::string_view input) const noexcept {
+    return BasicTokenViews<TokenType>::create(input, tokens_span());
+  }
+
+  /**
+   * @brief Returns a token with its quotes stripped and escapes resolved
+   *
+   * Tokens that need no rewriting are returned as views into input, others
+   * are decoded into arena. See TokenDecoder.
+   *
+   * @param input The string that was tokenized
+   * @param idx Index of the token
+   * @param arena Storage for rewritten tokens, consumed from the front
+   */
+  constexpr std::expected<std::string_view, Error> decode(
+      std::string_view input, std::size_t idx,
+      std::span<char>& arena) const noexcept {
+    auto token = (*this)[idx];
+    if (!token.has_value()) {
+      return std::unexpected(token.error());
+    }
+    if (std::size_t{token->offset} + token->length > input.size()) {
+      return std::unexpected(Error::IndexOutOfRange);
+    }
+    return TokenDecoder<Classes>::decode(token->view(input), arena);
+  }
+
+ private:
+  static constexpr std::size_t BlockSize = simd::BlockSize;
+  static constexpr auto Separator =
+      static_cast<std::uint8_t>(CharClass::Separator);
+  static constexpr auto Quote = static_cast<std::uint8_t>(CharClass::Quote);
+  static constexpr auto Escape = static_cast<std::uint8_t>(CharClass::Escape);
+  static constexpr auto Separators = Classes.members(CharClass::Separator);
+  static constexpr auto Quotes = Classes.members(CharClass::Quote);
+  static constexpr auto Escapes = Classes.members(CharClass::Escape);
+
+  constexpr Error emit(std::size_t offset, std::size_t length) noexcept {
+    if (count_ >= MaxTokens) {
+      return Error::MaximumSizeExceeded;
+    }
+    if (!TokenType::fits(offset, length)) {
+      return Error::ResultOutOfRange;
+    }
+    markers_[count_].offset = offset;
+    markers_[count_].length = length;
+    count_++;
+    return Error::Ok;
+  }
+
+  template <typename Callback>
+  static constexpr Error scan_scalar(std::string_view str,
+                                     Callback& on_token) {
+    const auto size = str.size();
+    const auto buf = str.data();
     std::size_t pos = 0;
     bool quoted = false;
-    bool scanning = false;
-
-    auto size = str.size();
-    auto buf = str.data();
+    bool escaped = false;
 
     while (pos < size) {
-      if (count_ >= MaxTokens) {
-        return std::unexpected(Error::MaximumSizeExceeded);
-      }
-
-      while (std::isspace(buf[pos])) {
+      while (pos < size && (Classes[buf[pos]] & Separator)) {
         pos++;
       }
 
-      scanning = true;
-      markers_[count_].offset = pos;
+      if (pos == size) {
+        break;
+      }
 
+      const auto start = pos;
       while (pos < size) {
-        char c = buf[pos];
-        if (isQuote(c)) {
+        const auto cls = Classes[buf[pos]];
+        if constexpr (Escapes.size > 0) {
+          if (escaped) {
+            escaped = false;
+            pos++;
+            continue;
+          }
+
+          if (cls & Escape) {
+            escaped = true;
+            pos++;
+            continue;
+          }
+        }
+
+        if (cls & Quote) {
           quoted = !quoted;
         }
 
-        if (std::isspace(c) && !quoted) {
-          markers_[count_].length = pos - markers_[count_].offset;
-          scanning = false;
-          count_++;
-          pos++;
+        if ((cls & Separator) && !quoted) {
           break;
         }
         pos++;
       }
-    }
 
-    if (scanning) {
-      markers_[count_].length = pos - markers_[count_].offset;
-      count_++;
+      if (auto err = on_token(start, pos - start); err != Error::Ok) {
+        return err;
+      }
     }
 
-    return count_;
+    return Error::Ok;
   }
 
-  std::expected<Token, Error> operator[](std::size_t idx) const noexcept {
-    if (idx >= MaxTokens || idx >= count_) {
-      return std::unexpected(Error::IndexOutOfRange);
-    }
-    return markers_[idx];
+#if MALIB_TOKENIZER_SIMD
+  struct block_masks {
+    std::uint64_t separator;
+    std::uint64_t quote;
+    std::uint64_t escape;
+  };
+
+  // Small classes are matched with one vector compare per member; tables
+  // with many special characters fall back to a lookup per byte.
+  static constexpr bool VectorClassify =
+      Separators.size + Quotes.size + Escapes.size <= 16;
+
+  using vector_type = simd::vector_type;
+  static constexpr std::size_t VectorSize = simd::VectorSize;
+
+  template <const CharClassTable::Members& Set>
+  static std::uint64_t match_set(vector_type v) noexcept {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      vector_type result = simd::none();
+      ((result = simd::either(result, simd::match(v, Set.chars[I]))), ...);
+      return simd::bits(result);
+    }(std::make_index_sequence<Set.size>{});
   }
 
-  std::span<const Token> tokens_span() const noexcept {
-    return std::span<const Token>(markers_.data(), count_);
+  /**
+   * @brief Classifies 64 bytes into one bitmask per character class
+   *
+   * Bit i of each mask describes block[i].
+   */
+  static block_masks classify(const char* block) noexcept {
+    block_masks masks{0, 0, 0};
+    if constexpr (VectorClassify) {
+      for (std::size_t i = 0; i < BlockSize; i += VectorSize) {
+        const vector_type v = simd::load(block + i);
+        masks.separator |= match_set<Separators>(v) << i;
+        masks.quote |= match_set<Quotes>(v) << i;
+        masks.escape |= match_set<Escapes>(v) << i;
+      }
+    } else {
+      for (std::size_t i = 0; i < BlockSize; ++i) {
+        const auto cls = Classes[block[i]];
+        masks.separator |= static_cast<std::uint64_t>(cls & Separator) << i;
+        masks.quote |= static_cast<std::uint64_t>((cls & Quote) != 0) << i;
+        masks.escape |= static_cast<std::uint64_t>((cls & Escape) != 0) << i;
+      }
+    }
+    return masks;
   }
 
-  auto tokens_views(std::string_view input) const noexcept {
-    return TokenViews{input, tokens_span()};
+  /**
+   * @brief Returns the mask of characters preceded by an odd run of escapes
+   *
+   * @param escape The escape character mask of the block
+   * @param carry 1 if the first character of the block is escaped; updated
+   * for the next block
+   */
+  static constexpr std::uint64_t find_escaped(std::uint64_t escape,
+                                              std::uint64_t& carry) noexcept {
+    constexpr std::uint64_t even_bits = 0x5555555555555555ULL;
+
+    escape &= ~carry;
+    const std::uint64_t follows_escape = (escape << 1) | carry;
+    const std::uint64_t odd_starts = escape & ~even_bits & ~follows_escape;
+    const std::uint64_t sum = odd_starts + escape;
+    carry = sum < odd_starts ? 1 : 0;
+    const std::uint64_t invert_mask = sum << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
   }
 
- private:
-  bool isQuote(char c) { return c == '\'' || c == '"'; }
+  template <typename Callback>
+  static Error scan_blocks(std::string_view str, Callback& on_token) {
+    const auto size = str.size();
+    std::uint64_t quote_state = 0;     // all ones while inside quotes
+    std::uint64_t escape_carry = 0;    // 1 if the next byte is escaped
+    std::uint64_t prev_token = 0;      // 1 if the previous byte was in a token
+    std::size_t token_start = 0;
+    bool in_token = false;
+
+    for (std::size_t base = 0; base < size; base += BlockSize) {
+      block_masks masks;
+      if (size - base >= BlockSize) {
+        masks = classify(str.data() + base);
+      } else {
+        // Pad the tail with NULs and mark the padding as separators; tokens
+        // are clamped to the input below
+        alignas(32) char tail[BlockSize]{};
+        std::memcpy(tail, str.data() + base, size - base);
+        masks = classify(tail);
+        masks.separator |= ~std::uint64_t{0} << (size - base);
+      }
+
+      if constexpr (Escapes.size > 0) {
+        if (masks.escape != 0 || escape_carry != 0) {
+          const std::uint64_t escaped =
+              find_escaped(masks.escape, escape_carry);
+          masks.quote &= ~escaped;
+          masks.separator &= ~escaped;
+        }
+      }
+
+      const std::uint64_t inside = simd::prefix_xor(masks.quote) ^ quote_state;
+      quote_state = static_cast<std::uint64_t>(
+          static_cast<std::int64_t>(inside) >> 63);
+
+      const std::uint64_t token = ~(masks.separator & ~inside);
+      const std::uint64_t shifted = (token << 1) | prev_token;
+      prev_token = token >> 63;
+
+      // Token starts and ends alternate, so a single pass over the edges
+      // recovers every token in order
+      std::uint64_t edges = (token & ~shifted) | (~token & shifted);
+      while (edges != 0) {
+        const auto pos = base + std::countr_zero(edges);
+        edges &= edges - 1;
+
+        if (pos >= size) {
+          break;
+        }
+
+        if (!in_token) {
+          token_start = pos;
+          in_token = true;
+        } else {
+          in_token = false;
+          if (auto err = on_token(token_start, pos - token_start);
+              err != Error::Ok) {
+            return err;
+          }
+        }
+      }
+    }
+
+    if (in_token) {
+      return on_token(token_start, size - token_start);
+    }
+
+    return Error::Ok;
+  }
+#endif
 
  private:
-  std::array<Token, MaxTokens> markers_{};
+  std::array<TokenType, MaxTokens> markers_{};
   std::size_t count_{0};
 };
 
-}  // namespace malib
\ No newline at end of file
+/**
+ * @brief A Tokenizer producing 8-byte WideToken entries
+ */
+template <std::size_t MaxTokens,
+          CharClassTable Classes = char_classes::shell>
+using WideTokenizer = Tokenizer<MaxTokens, Classes, WideToken>;
+
+}  // namespace malib
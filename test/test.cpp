@@ -11,6 +11,21 @@ extern void test_StringConverter();
 extern void test_ObservableData();
 extern void test_FixedSizeWaitableQueue();
 extern void test_FixedLengthLinearBuffer();
+extern void test_ConcurrentLinearBuffer();
+extern void test_ChainedBuffer();
+extern void test_Format();
+extern void test_StreamTokenizer();
+extern void test_TokenRange();
+extern void test_TokenDecoder();
+extern void test_CsvReader();
+extern void test_ParallelTokenizer();
+extern void test_ArgumentParser();
+extern void test_StaticShell();
+extern void test_ShellJobs();
+extern void test_PrefixIndex();
+extern void test_ShellServer();
+extern void test_ShellRpc();
+extern void test_InplaceFunction();
 
 void setUp() {}
 
@@ -30,6 +45,21 @@ int main() {
   test_ObservableData();
   test_FixedSizeWaitableQueue();
   test_FixedLengthLinearBuffer();
+  test_ConcurrentLinearBuffer();
+  test_ChainedBuffer();
+  test_Format();
+  test_StreamTokenizer();
+  test_TokenRange();
+  test_TokenDecoder();
+  test_CsvReader();
+  test_ParallelTokenizer();
+  test_ArgumentParser();
+  test_StaticShell();
+  test_ShellJobs();
+  test_PrefixIndex();
+  test_ShellServer();
+  test_ShellRpc();
+  test_InplaceFunction();
 
   return UNITY_END();
 }
@@ -0,0 +1,144 @@
+#include <unity.h>
+
+#include <malib/ArgumentParser.hpp>
+#include <malib/TokenRange.hpp>
+#include <malib/Tokenizer.hpp>
+#include <string_view>
+
+namespace {
+struct copy_args {
+  bool verbose{false};
+  bool force{false};
+  int count{1};
+  double ratio{0.0};
+  std::string_view mode{};
+  std::string_view source{};
+  std::string_view target{};
+};
+
+constexpr malib::args::schema copy_schema{
+    malib::args::flag<&copy_args::verbose>("verbose", 'v'),
+    malib::args::flag<&copy_args::force>("force", 'f'),
+    malib::args::option<&copy_args::count>("count", 'c'),
+    malib::args::option<&copy_args::ratio>("ratio"),
+    malib::args::option<&copy_args::mode>("mode", 'm'),
+    malib::args::positional<&copy_args::source>("source"),
+    malib::args::positional<&copy_args::target>("target"),
+};
+
+auto parse(std::string_view line) {
+  return copy_schema.parse(malib::TokenRange<>{line});
+}
+}  // namespace
+
+void test_ArgumentParser_long_options() {
+  auto result = parse("--verbose --count=3 --ratio 0.5 --mode fast a.txt b.txt");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->verbose);
+  TEST_ASSERT_FALSE(result->force);
+  TEST_ASSERT_EQUAL(3, result->count);
+  TEST_ASSERT_EQUAL_DOUBLE(0.5, result->ratio);
+  TEST_ASSERT_EQUAL_STRING_LEN("fast", result->mode.data(), 4);
+  TEST_ASSERT_EQUAL_STRING_LEN("a.txt", result->source.data(), 5);
+  TEST_ASSERT_EQUAL_STRING_LEN("b.txt", result->target.data(), 5);
+}
+
+void test_ArgumentParser_short_options() {
+  auto result = parse("-vf -c 7 -mslow src");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->verbose);
+  TEST_ASSERT_TRUE(result->force);
+  TEST_ASSERT_EQUAL(7, result->count);
+  TEST_ASSERT_EQUAL_STRING_LEN("slow", result->mode.data(), 4);
+  TEST_ASSERT_EQUAL_STRING_LEN("src", result->source.data(), 3);
+  TEST_ASSERT_TRUE(result->target.empty());
+}
+
+void test_ArgumentParser_key_value_and_defaults() {
+  auto result = parse("count=9 x=y");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(9, result->count);
+  // Unknown keys are positionals
+  TEST_ASSERT_EQUAL_STRING_LEN("x=y", result->source.data(), 3);
+  TEST_ASSERT_FALSE(result->verbose);
+
+  result = parse("");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(1, result->count);
+}
+
+void test_ArgumentParser_end_of_options() {
+  auto result = parse("-c -2 -- --verbose -v");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(-2, result->count);
+  TEST_ASSERT_FALSE(result->verbose);
+  TEST_ASSERT_EQUAL_STRING_LEN("--verbose", result->source.data(), 9);
+  TEST_ASSERT_EQUAL_STRING_LEN("-v", result->target.data(), 2);
+}
+
+void test_ArgumentParser_errors() {
+  auto result = parse("--unknown");
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("-x");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("--count");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("--verbose=1");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("a b c");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("--count=abc");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("--count=99999999999");
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange, result.error());
+
+  // Option values must be a whole number, not just start with one
+  result = parse("--count=5abc");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("-c 2.5");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+
+  result = parse("--ratio 0.5x");
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result.error());
+}
+
+void test_ArgumentParser_perfect_hash() {
+  static_assert(copy_schema.find("verbose").value() == 0);
+  static_assert(copy_schema.find("mode").value() == 4);
+  static_assert(!copy_schema.find("source").has_value());
+  static_assert(!copy_schema.find("missing").has_value());
+  TEST_ASSERT_EQUAL(2, copy_schema.find("count").value());
+}
+
+void test_ArgumentParser_token_views() {
+  std::string_view input = "cp -v --count 2 from to";
+  malib::Tokenizer<8> tokenizer{};
+  TEST_ASSERT_TRUE(tokenizer.tokenize(input).has_value());
+  auto args = malib::TokenViews::create(input,
+                                        tokenizer.tokens_span().subspan(1));
+  TEST_ASSERT_TRUE(args.has_value());
+
+  auto result = copy_schema.parse(*args);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->verbose);
+  TEST_ASSERT_EQUAL(2, result->count);
+  TEST_ASSERT_EQUAL_STRING_LEN("to", result->target.data(), 2);
+}
+
+void test_ArgumentParser() {
+  RUN_TEST(test_ArgumentParser_long_options);
+  RUN_TEST(test_ArgumentParser_short_options);
+  RUN_TEST(test_ArgumentParser_key_value_and_defaults);
+  RUN_TEST(test_ArgumentParser_end_of_options);
+  RUN_TEST(test_ArgumentParser_errors);
+  RUN_TEST(test_ArgumentParser_perfect_hash);
+  RUN_TEST(test_ArgumentParser_token_views);
+}
@@ -0,0 +1,160 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <malib/ChainedBuffer.hpp>
+#include <string>
+
+namespace {
+struct collecting_output {
+  std::string output{};
+  std::size_t writes{0};
+
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    output.append(buf, size);
+    writes++;
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+
+// Accepts at most chunk bytes per write and limit bytes in total
+struct short_output {
+  std::string output{};
+  std::size_t chunk;
+  std::size_t limit;
+
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    size = std::min({size, chunk, limit - output.size()});
+    output.append(buf, size);
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+}  // namespace
+
+void test_ChainedBuffer_grows_by_segments() {
+  malib::SegmentPool<4, 8> pool{};
+  malib::ChainedBuffer<4, 8> buffer{pool};
+  TEST_ASSERT_TRUE(buffer.empty());
+  TEST_ASSERT_EQUAL(0, buffer.segment_count());
+
+  auto result = buffer.write("abc");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(3, result.value());
+  TEST_ASSERT_EQUAL(1, buffer.segment_count());
+  TEST_ASSERT_EQUAL(7, pool.available());
+
+  result = buffer.write("defghij");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(7, result.value());
+  TEST_ASSERT_EQUAL(10, buffer.size());
+  TEST_ASSERT_EQUAL(3, buffer.segment_count());
+  TEST_ASSERT_EQUAL(5, pool.available());
+
+  std::string joined{};
+  std::size_t segments = 0;
+  for (auto segment : buffer.segments()) {
+    TEST_ASSERT_TRUE(segment.size() <= 4);
+    joined.append(segment.data(), segment.size());
+    segments++;
+  }
+  TEST_ASSERT_EQUAL(3, segments);
+  TEST_ASSERT_EQUAL_STRING("abcdefghij", joined.c_str());
+}
+
+void test_ChainedBuffer_pool_exhausted() {
+  malib::SegmentPool<4, 2> pool{};
+  malib::ChainedBuffer<4, 2> buffer{pool};
+
+  auto result = buffer.write("0123456789");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(8, result.value());
+  TEST_ASSERT_EQUAL(0, pool.available());
+
+  result = buffer.write("x");
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::BufferFull, result.error());
+
+  result = buffer.write(nullptr, 1);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::NullPointerInput, result.error());
+}
+
+void test_ChainedBuffer_clear_returns_segments() {
+  malib::SegmentPool<4, 4> pool{};
+  {
+    malib::ChainedBuffer<4, 4> buffer{pool};
+    buffer.write("0123456789");
+    TEST_ASSERT_EQUAL(1, pool.available());
+
+    buffer.clear();
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_EQUAL(4, pool.available());
+
+    buffer.write("abcde");
+    TEST_ASSERT_EQUAL(2, pool.available());
+  }
+  // Destruction releases the chain as well
+  TEST_ASSERT_EQUAL(4, pool.available());
+}
+
+void test_ChainedBuffer_write_to() {
+  malib::SegmentPool<8, 4> pool{};
+  malib::ChainedBuffer<8, 4> buffer{pool};
+  buffer.write("hello, ");
+  buffer.write("chained world");
+
+  collecting_output output{};
+  auto result = buffer.write_to(output);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(20, result.value());
+  TEST_ASSERT_EQUAL(3, output.writes);
+  TEST_ASSERT_EQUAL_STRING("hello, chained world", output.output.c_str());
+}
+
+void test_ChainedBuffer_write_to_short_writes() {
+  malib::SegmentPool<8, 4> pool{};
+  malib::ChainedBuffer<8, 4> buffer{pool};
+  buffer.write("hello, chained world");
+
+  short_output partial{.chunk = 3, .limit = 100};
+  auto result = buffer.write_to(partial);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(20, result.value());
+  TEST_ASSERT_EQUAL_STRING("hello, chained world", partial.output.c_str());
+
+  short_output full{.chunk = 100, .limit = 10};
+  result = buffer.write_to(full);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(10, result.value());
+  TEST_ASSERT_EQUAL_STRING("hello, cha", full.output.c_str());
+}
+
+void test_ChainedBuffer_move() {
+  malib::SegmentPool<4, 4> pool{};
+  malib::ChainedBuffer<4, 4> first{pool};
+  first.write("abcdef");
+
+  malib::ChainedBuffer<4, 4> second{std::move(first)};
+  TEST_ASSERT_TRUE(first.empty());
+  TEST_ASSERT_EQUAL(6, second.size());
+  TEST_ASSERT_EQUAL(2, second.segment_count());
+  TEST_ASSERT_EQUAL(2, pool.available());
+}
+
+void test_ChainedBuffer() {
+  RUN_TEST(test_ChainedBuffer_grows_by_segments);
+  RUN_TEST(test_ChainedBuffer_pool_exhausted);
+  RUN_TEST(test_ChainedBuffer_clear_returns_segments);
+  RUN_TEST(test_ChainedBuffer_write_to);
+  RUN_TEST(test_ChainedBuffer_write_to_short_writes);
+  RUN_TEST(test_ChainedBuffer_move);
+}
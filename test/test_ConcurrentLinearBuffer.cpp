@@ -0,0 +1,150 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <atomic>
+#include <malib/ConcurrentLinearBuffer.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_ConcurrentLinearBuffer_single_writer() {
+  malib::ConcurrentLinearBuffer<char, 8> buffer;
+  TEST_ASSERT_TRUE(buffer.empty());
+  TEST_ASSERT_EQUAL(8, buffer.free_space());
+
+  auto result = buffer.write("hello");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(5, result.value());
+  TEST_ASSERT_EQUAL(5, buffer.size());
+  TEST_ASSERT_EQUAL(3, buffer.free_space());
+
+  auto view = buffer.as_string_view();
+  TEST_ASSERT_EQUAL_STRING_LEN("hello", view.data(), view.size());
+}
+
+void test_ConcurrentLinearBuffer_partial_and_full() {
+  malib::ConcurrentLinearBuffer<int, 4> buffer;
+  int data[] = {1, 2, 3, 4, 5};
+
+  auto result = buffer.write(data, 3);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(3, result.value());
+
+  result = buffer.write(data + 3, 2);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(1, result.value());
+  TEST_ASSERT_TRUE(buffer.full());
+  TEST_ASSERT_EQUAL(0, buffer.free_space());
+
+  result = buffer.write(data, 1);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::BufferFull, result.error());
+
+  auto snapshot = buffer.snapshot();
+  TEST_ASSERT_EQUAL(4, snapshot.size());
+  TEST_ASSERT_EQUAL_INT_ARRAY(data, snapshot.data(), 4);
+}
+
+void test_ConcurrentLinearBuffer_null_and_clear() {
+  malib::ConcurrentLinearBuffer<char, 4> buffer;
+  auto result = buffer.write(nullptr, 1);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::NullPointerInput, result.error());
+
+  buffer.write("abcd");
+  TEST_ASSERT_TRUE(buffer.full());
+  buffer.clear();
+  TEST_ASSERT_TRUE(buffer.empty());
+  TEST_ASSERT_FALSE(buffer.full());
+  TEST_ASSERT_EQUAL(4, buffer.write("wxyz").value());
+}
+
+void test_ConcurrentLinearBuffer_failed_writes_do_not_reserve() {
+  malib::ConcurrentLinearBuffer<char, 4> buffer;
+  TEST_ASSERT_EQUAL(3, buffer.write("abc").value());
+  TEST_ASSERT_EQUAL(1, buffer.write("defg").value());
+  for (int i = 0; i < 100; ++i) {
+    TEST_ASSERT_EQUAL(malib::Error::BufferFull, buffer.write("hi").error());
+  }
+  TEST_ASSERT_EQUAL(0, buffer.free_space());
+  TEST_ASSERT_EQUAL(4, buffer.size());
+
+  buffer.clear();
+  TEST_ASSERT_EQUAL(2, buffer.write("hi").value());
+  TEST_ASSERT_EQUAL(2, buffer.size());
+  TEST_ASSERT_EQUAL(2, buffer.free_space());
+}
+
+template <std::size_t MaxWriters>
+void run_producers() {
+  static constexpr std::size_t Threads = 8;
+  static constexpr std::size_t RecordsPerThread = 500;
+  static constexpr std::size_t RecordSize = 4;
+  malib::ConcurrentLinearBuffer<char, Threads * RecordsPerThread * RecordSize,
+                                MaxWriters>
+      buffer;
+
+  std::atomic<bool> done{false};
+  std::atomic<bool> reader_ok{true};
+
+  // Every committed prefix must consist of whole, untorn records
+  std::thread reader([&]() {
+    while (!done.load()) {
+      auto snapshot = buffer.snapshot();
+      for (std::size_t i = 0; i + RecordSize <= snapshot.size();
+           i += RecordSize) {
+        if (snapshot[i] != snapshot[i + RecordSize - 1]) {
+          reader_ok = false;
+        }
+      }
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (std::size_t t = 0; t < Threads; ++t) {
+    writers.emplace_back([&buffer, t]() {
+      char record[RecordSize];
+      std::fill_n(record, RecordSize, static_cast<char>('a' + t));
+      for (std::size_t i = 0; i < RecordsPerThread; ++i) {
+        buffer.write(record, RecordSize);
+      }
+    });
+  }
+
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done = true;
+  reader.join();
+
+  TEST_ASSERT_TRUE(reader_ok.load());
+  TEST_ASSERT_TRUE(buffer.full());
+
+  std::size_t counts[Threads]{};
+  auto view = buffer.as_string_view();
+  for (std::size_t i = 0; i < view.size(); i += RecordSize) {
+    TEST_ASSERT_EQUAL(view[i], view[i + RecordSize - 1]);
+    counts[view[i] - 'a']++;
+  }
+
+  for (auto count : counts) {
+    TEST_ASSERT_EQUAL(RecordsPerThread, count);
+  }
+}
+
+void test_ConcurrentLinearBuffer_multiple_producers() { run_producers<16>(); }
+
+// More writers than commit records: writers wait for a free record, and
+// records are reused many times over
+void test_ConcurrentLinearBuffer_more_writers_than_records() {
+  run_producers<2>();
+}
+
+void test_ConcurrentLinearBuffer() {
+  RUN_TEST(test_ConcurrentLinearBuffer_single_writer);
+  RUN_TEST(test_ConcurrentLinearBuffer_partial_and_full);
+  RUN_TEST(test_ConcurrentLinearBuffer_null_and_clear);
+  RUN_TEST(test_ConcurrentLinearBuffer_failed_writes_do_not_reserve);
+  RUN_TEST(test_ConcurrentLinearBuffer_multiple_producers);
+  RUN_TEST(test_ConcurrentLinearBuffer_more_writers_than_records);
+}
@@ -0,0 +1,192 @@
+#include <unity.h>
+
+#include <array>
+#include <malib/CsvReader.hpp>
+#include <span>
+#include <string>
+
+namespace {
+template <typename Row>
+void assert_fields(const Row& row, std::initializer_list<std::string_view> fields) {
+  TEST_ASSERT_EQUAL(fields.size(), row.size());
+  std::size_t i = 0;
+  for (auto expected : fields) {
+    auto field = row[i++];
+    TEST_ASSERT_TRUE(field.has_value());
+    TEST_ASSERT_EQUAL(expected.size(), field->size());
+    TEST_ASSERT_EQUAL_STRING_LEN(expected.data(), field->data(),
+                                 expected.size());
+  }
+}
+}  // namespace
+
+void test_CsvReader_rows() {
+  malib::CsvReader<4> reader{"a,b,c\n1,2,3\r\n,,\nlast,row"};
+
+  auto row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"a", "b", "c"});
+
+  row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"1", "2", "3"});
+
+  row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"", "", ""});
+
+  row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"last", "row"});
+
+  TEST_ASSERT_TRUE(reader.done());
+  row = reader.next();
+  TEST_ASSERT_FALSE(row.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::EmptyInput, row.error());
+}
+
+void test_CsvReader_crlf_at_end_of_input() {
+  malib::CsvReader<2> reader{"a,b\r\n\"c\",d\r"};
+  auto row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"a", "b"});
+
+  row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"c", "d"});
+  TEST_ASSERT_TRUE(reader.done());
+
+  malib::CsvReader<2> blank{"a\n\r"};
+  TEST_ASSERT_TRUE(blank.next().has_value());
+  TEST_ASSERT_FALSE(blank.next().has_value());
+}
+
+void test_CsvReader_quoted_fields() {
+  malib::CsvReader<4> reader{
+      "\"name, full\",\"multi\nline\",\"say \"\"hi\"\"\"\n\"\",x\n"};
+
+  auto row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"name, full", "multi\nline", "say \"\"hi\"\""});
+
+  std::array<char, 16> storage{};
+  std::span<char> arena{storage};
+  auto decoded = decltype(reader)::decode_field(*(*row)[2], arena);
+  TEST_ASSERT_TRUE(decoded.has_value());
+  TEST_ASSERT_EQUAL(8, decoded->size());
+  TEST_ASSERT_EQUAL_STRING_LEN("say \"hi\"", decoded->data(), 8);
+
+  auto plain = decltype(reader)::decode_field(*(*row)[0], arena);
+  TEST_ASSERT_TRUE(plain.has_value());
+  TEST_ASSERT_TRUE(plain->data() == (*row)[0]->data());
+
+  row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"", "x"});
+  TEST_ASSERT_TRUE(reader.done());
+}
+
+void test_CsvReader_blank_lines_are_skipped() {
+  malib::CsvReader<2> reader{"a\n\n\r\nb\n"};
+  auto row = reader.next();
+  assert_fields(*row, {"a"});
+  row = reader.next();
+  assert_fields(*row, {"b"});
+  TEST_ASSERT_FALSE(reader.next().has_value());
+  TEST_ASSERT_EQUAL(4, reader.rows());
+}
+
+void test_CsvReader_long_input_across_blocks() {
+  std::string input{};
+  for (int i = 0; i < 200; ++i) {
+    input += std::to_string(i) + ",\"quoted, " + std::to_string(i) +
+             "\",tail\n";
+  }
+
+  malib::CsvReader<3> reader{input};
+  for (int i = 0; i < 200; ++i) {
+    auto row = reader.next();
+    TEST_ASSERT_TRUE(row.has_value());
+    const auto index = std::to_string(i);
+    const auto quoted = "quoted, " + index;
+    assert_fields(*row, {index, quoted, "tail"});
+  }
+  TEST_ASSERT_FALSE(reader.next().has_value());
+}
+
+void test_CsvReader_too_many_fields() {
+  malib::CsvReader<2> reader{"a,b,c\nd,e\n"};
+  auto row = reader.next();
+  TEST_ASSERT_FALSE(row.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded, row.error());
+
+  // The reader continues with the next row
+  row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"d", "e"});
+}
+
+void test_CsvReader_tsv() {
+  malib::TsvReader<3> reader{"a\tb,c\t\"d\te\"\n"};
+  auto row = reader.next();
+  TEST_ASSERT_TRUE(row.has_value());
+  assert_fields(*row, {"a", "b,c", "d\te"});
+}
+
+void test_CsvReader_read_columns() {
+  malib::CsvReader<4> reader{
+      "1,20.5,temp,true\n2,-3.25,humidity,0\n3,1e3,pressure,1\n"};
+
+  std::array<int, 4> ids{};
+  std::array<double, 4> values{};
+  std::array<std::string_view, 4> names{};
+  auto rows = reader.read_columns(std::span{ids}, std::span{values},
+                                  std::span{names});
+  TEST_ASSERT_TRUE(rows.has_value());
+  TEST_ASSERT_EQUAL(3, rows.value());
+  TEST_ASSERT_EQUAL(2, ids[1]);
+  TEST_ASSERT_EQUAL_DOUBLE(-3.25, values[1]);
+  TEST_ASSERT_EQUAL_DOUBLE(1000.0, values[2]);
+  TEST_ASSERT_EQUAL_STRING_LEN("pressure", names[2].data(), 8);
+}
+
+void test_CsvReader_read_columns_errors() {
+  std::array<int, 2> ids{};
+  std::array<bool, 2> flags{};
+
+  malib::CsvReader<2> bad_number{"1,true\nx2,false\n"};
+  auto rows = bad_number.read_columns(std::span{ids}, std::span{flags});
+  TEST_ASSERT_FALSE(rows.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, rows.error());
+
+  malib::CsvReader<2> missing{"1\n"};
+  rows = missing.read_columns(std::span{ids}, std::span{flags});
+  TEST_ASSERT_FALSE(rows.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, rows.error());
+
+  std::array<std::uint8_t, 2> small{};
+  malib::CsvReader<2> overflow{"300\n"};
+  rows = overflow.read_columns(std::span{small});
+  TEST_ASSERT_FALSE(rows.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange, rows.error());
+
+  // Stops when the columns are full
+  malib::CsvReader<2> full{"1,1\n2,0\n3,1\n"};
+  rows = full.read_columns(std::span{ids}, std::span{flags});
+  TEST_ASSERT_TRUE(rows.has_value());
+  TEST_ASSERT_EQUAL(2, rows.value());
+  TEST_ASSERT_FALSE(flags[1]);
+  TEST_ASSERT_FALSE(full.done());
+}
+
+void test_CsvReader() {
+  RUN_TEST(test_CsvReader_rows);
+  RUN_TEST(test_CsvReader_crlf_at_end_of_input);
+  RUN_TEST(test_CsvReader_quoted_fields);
+  RUN_TEST(test_CsvReader_blank_lines_are_skipped);
+  RUN_TEST(test_CsvReader_long_input_across_blocks);
+  RUN_TEST(test_CsvReader_too_many_fields);
+  RUN_TEST(test_CsvReader_tsv);
+  RUN_TEST(test_CsvReader_read_columns);
+  RUN_TEST(test_CsvReader_read_columns_errors);
+}
@@ -769,6 +769,42 @@ void test_FixedLengthLinearBuffer_reset_on_read() {
   }
 }
 
+void test_FixedLengthLinearBuffer_thread_safe_write_read() {
+  malib::FixedLengthLinearBuffer<int, 64, true> buffer;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&buffer, t]() {
+      for (int i = 0; i < 16; ++i) {
+        int value = t;
+        buffer.write(&value, 1);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  TEST_ASSERT_TRUE(buffer.full());
+  TEST_ASSERT_EQUAL(0, buffer.free_space());
+
+  int extra = 0;
+  auto result = buffer.write(&extra, 1);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::BufferFull, result.error());
+
+  int read_data[64];
+  auto read_result = buffer.read(read_data, 64);
+  TEST_ASSERT_TRUE(read_result.has_value());
+  TEST_ASSERT_EQUAL(64, read_result.value());
+  TEST_ASSERT_TRUE(buffer.empty());
+
+  read_result = buffer.read(read_data, 1);
+  TEST_ASSERT_FALSE(read_result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::BufferEmpty, read_result.error());
+}
+
 void test_FixedLengthLinearBuffer() {
   RUN_TEST(test_FixedLengthLinearBuffer_trivially_copyable_type);
   RUN_TEST(test_FixedLengthLinearBuffer_non_trivially_copyable_type);
@@ -791,4 +827,5 @@ void test_FixedLengthLinearBuffer() {
   RUN_TEST(test_FixedLengthLinearBuffer_format_to_boundary);
   RUN_TEST(test_FixedLengthLinearBuffer_string_view);
   RUN_TEST(test_FixedLengthLinearBuffer_reset_on_read);
+  RUN_TEST(test_FixedLengthLinearBuffer_thread_safe_write_read);
 }
\ No newline at end of file
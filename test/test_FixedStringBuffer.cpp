@@ -230,6 +230,39 @@ void test_fixed_string_buffer_all_features() {
   }
 }
 
+void test_fixed_string_buffer_write_empty() {
+  malib::FixedStringBuffer<4> buffer{};
+  auto result = buffer.write("x", 0);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(0, result.value());
+  TEST_ASSERT_EQUAL(0, buffer.size());
+
+  // A full buffer still accepts empty writes
+  buffer.write("abcd");
+  result = buffer.write("y", 0);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(4, buffer.size());
+  TEST_ASSERT_EQUAL_STRING_LEN("abcd", buffer.view().data(), 4);
+}
+
+void test_fixed_string_buffer_constexpr() {
+  constexpr auto buffer = [] {
+    malib::FixedStringBuffer<16> buffer{};
+    buffer.write("key=");
+    buffer.write("value", 5);
+    return buffer;
+  }();
+  static_assert(buffer.view() == "key=value");
+  static_assert(buffer.size() == 9);
+
+  constexpr auto overflow = [] {
+    malib::FixedStringBuffer<4> buffer{};
+    return buffer.write("too long").error_or(malib::Error::Ok);
+  }();
+  static_assert(overflow == malib::Error::MaximumSizeExceeded);
+  TEST_ASSERT_EQUAL_STRING_LEN("key=value", buffer.view().data(), 9);
+}
+
 void test_FixedStringBuffer() {
   RUN_TEST(test_fixed_string_buffer_copy);
   RUN_TEST(test_fixed_string_buffer_reset);
@@ -243,4 +276,6 @@ void test_FixedStringBuffer() {
   RUN_TEST(test_fixed_string_buffer_format);
   RUN_TEST(test_fixed_string_buffer_write);
   RUN_TEST(test_fixed_string_buffer_all_features);
+  RUN_TEST(test_fixed_string_buffer_write_empty);
+  RUN_TEST(test_fixed_string_buffer_constexpr);
 }
@@ -0,0 +1,169 @@
+#include <unity.h>
+
+#include <malib/FixedLengthLinearBuffer.hpp>
+#include <malib/FixedStringBuffer.hpp>
+#include <malib/Format.hpp>
+#include <limits>
+#include <string>
+
+namespace {
+struct string_output {
+  std::string output{};
+  std::size_t writes{0};
+
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    output.append(buf, size);
+    writes++;
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+}  // namespace
+
+void test_Format_integers_and_floats() {
+  malib::FixedLengthLinearBuffer<char, 64> buffer;
+  auto result = malib::format_to<"Test {:d}, {:.2f}">(buffer, 42, 3.14159);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_FALSE(result->truncated());
+  TEST_ASSERT_EQUAL(13, result->size);
+  TEST_ASSERT_EQUAL(13, buffer.size());
+  auto view = buffer.as_string_view();
+  TEST_ASSERT_EQUAL_STRING_LEN("Test 42, 3.14", view.data(), view.size());
+}
+
+void test_Format_presentation_types() {
+  string_output out{};
+  auto result = malib::format_to<"{:x} {:X} {:b} {:o} {:e} {} {}">(
+      out, 255, 255, 5, 8, 1500.0, -7, 0.5);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_STRING("ff FF 101 10 1.500000e+03 -7 0.5",
+                           out.output.c_str());
+}
+
+void test_Format_strings_and_alignment() {
+  string_output out{};
+  auto result = malib::format_to<"[{:>5}|{:<5}|{:*^7}|{}|{}|{:.2}]">(
+      out, "abc", std::string_view("xyz"), std::string("mid"), 'c', true,
+      "truncate");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_STRING("[  abc|xyz  |**mid**|c|true|tr]",
+                           out.output.c_str());
+}
+
+void test_Format_escaped_braces() {
+  string_output out{};
+  auto result = malib::format_to<"{{{}}}">(out, 7);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_STRING("{7}", out.output.c_str());
+  TEST_ASSERT_EQUAL(3, result->size);
+}
+
+void test_Format_bulk_writes() {
+  string_output out{};
+  malib::format_to<"id={} name={}">(out, 12345, "sensor");
+  // Two literal runs and two arguments, no per-character writes
+  TEST_ASSERT_EQUAL(4, out.writes);
+  TEST_ASSERT_EQUAL_STRING("id=12345 name=sensor", out.output.c_str());
+}
+
+void test_Format_truncation_linear_buffer() {
+  malib::FixedLengthLinearBuffer<char, 8> buffer;
+  auto result = malib::format_to<"{:>12}">(buffer, "abc");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->truncated());
+  TEST_ASSERT_EQUAL(8, result->written);
+  TEST_ASSERT_EQUAL(12, result->size);
+  TEST_ASSERT_TRUE(buffer.full());
+}
+
+void test_Format_truncation_string_buffer() {
+  malib::FixedStringBuffer<6> buffer{};
+  auto result = malib::format_to<"value={}">(buffer, 1234);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->truncated());
+  TEST_ASSERT_EQUAL(6, result->written);
+  TEST_ASSERT_EQUAL(10, result->size);
+  TEST_ASSERT_EQUAL_STRING_LEN("value=", buffer.view().data(),
+                               buffer.view().size());
+}
+
+void test_Format_formatted_size() {
+  string_output out{};
+  malib::format_to<"{}-{:04}">(out, 1234, 5);
+  TEST_ASSERT_EQUAL_STRING("1234-0005", out.output.c_str());
+  TEST_ASSERT_EQUAL(out.output.size(),
+                    malib::formatted_size<"{}-{:04}">(1234, 5));
+}
+
+void test_Format_zero_padding() {
+  string_output out{};
+  auto result =
+      malib::format_to<"{:04}|{:05}|{:08.3f}|{:08.3f}|{:06x}|{:>04}">(
+          out, 5, -42, 3.14159, -3.14159, 255, 7);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_STRING("0005|-0042|0003.142|-003.142|0000ff|   7",
+                           out.output.c_str());
+
+  out.output.clear();
+  malib::format_to<"{:06}|{:06}|{:03d}|{:02}">(
+      out, std::numeric_limits<double>::infinity(), -1.5, true, 123);
+  TEST_ASSERT_EQUAL_STRING("   inf|-001.5|001|123", out.output.c_str());
+
+  using malib::format_detail::accepts;
+  static_assert(!accepts<"{:05}", const char*>);
+  static_assert(!accepts<"{:05}", char>);
+  static_assert(!accepts<"{:05}", bool>);
+  static_assert(!accepts<"{:05c}", int>);
+  static_assert(accepts<"{:05x}", char>);
+}
+
+void test_Format_integer_presentations_of_bool_and_char() {
+  string_output out{};
+  auto result =
+      malib::format_to<"{:d} {:x} {:c} {:d} {:>3c}|{:s}">(out, true, 'A', 66,
+                                                           'a', 67, false);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_STRING("1 41 B 97   C|false", out.output.c_str());
+
+  out.output.clear();
+  auto invalid = malib::format_to<"{:c}">(out, 1000);
+  TEST_ASSERT_FALSE(invalid.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange, invalid.error());
+}
+
+void test_Format_rejects_specs_for_the_wrong_type() {
+  using malib::format_detail::accepts;
+  static_assert(accepts<"{:d} {:.2f} {:.3s} {:c}", int, double, const char*,
+                        char>);
+  static_assert(!accepts<"{:f}", int>);
+  static_assert(!accepts<"{:e}", long>);
+  static_assert(!accepts<"{:.2}", int>);
+  static_assert(!accepts<"{:.2d}", int>);
+  static_assert(!accepts<"{:s}", int>);
+  static_assert(!accepts<"{:c}", bool>);
+  static_assert(!accepts<"{:.1}", bool>);
+  static_assert(!accepts<"{:s}", char>);
+  static_assert(!accepts<"{:.1c}", char>);
+  static_assert(!accepts<"{:d}", double>);
+  static_assert(!accepts<"{:x}", float>);
+  static_assert(!accepts<"{:d}", const char*>);
+  static_assert(!accepts<"{} {:f}", double, int>);
+}
+
+void test_Format() {
+  RUN_TEST(test_Format_integers_and_floats);
+  RUN_TEST(test_Format_presentation_types);
+  RUN_TEST(test_Format_strings_and_alignment);
+  RUN_TEST(test_Format_escaped_braces);
+  RUN_TEST(test_Format_bulk_writes);
+  RUN_TEST(test_Format_truncation_linear_buffer);
+  RUN_TEST(test_Format_truncation_string_buffer);
+  RUN_TEST(test_Format_formatted_size);
+  RUN_TEST(test_Format_zero_padding);
+  RUN_TEST(test_Format_integer_presentations_of_bool_and_char);
+  RUN_TEST(test_Format_rejects_specs_for_the_wrong_type);
+}
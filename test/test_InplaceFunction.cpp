@@ -0,0 +1,95 @@
+#include <unity.h>
+
+#include <malib/InplaceFunction.hpp>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+namespace {
+int twice(int value) { return value * 2; }
+
+struct counted {
+  static inline int alive = 0;
+  counted() { alive++; }
+  counted(counted&&) noexcept { alive++; }
+  ~counted() { alive--; }
+  int operator()(int value) const { return value + 1; }
+};
+}  // namespace
+
+void test_InplaceFunction_call() {
+  int base = 40;
+  malib::inplace_function<int(int)> add{[&base](int v) { return base + v; }};
+  TEST_ASSERT_TRUE(static_cast<bool>(add));
+  TEST_ASSERT_EQUAL(42, add(2));
+
+  malib::inplace_function<int(int)> pointer{&twice};
+  TEST_ASSERT_EQUAL(8, pointer(4));
+
+  // The target keeps its state across calls, also through const
+  const malib::inplace_function<int()> counter{[n = 0]() mutable {
+    return ++n;
+  }};
+  counter();
+  TEST_ASSERT_EQUAL(2, counter());
+}
+
+void test_InplaceFunction_empty() {
+  malib::inplace_function<void()> empty{};
+  TEST_ASSERT_TRUE(empty == nullptr);
+  malib::inplace_function<void()> null{nullptr};
+  TEST_ASSERT_FALSE(static_cast<bool>(null));
+  int (*no_function)(int) = nullptr;
+  malib::inplace_function<int(int)> from_null{no_function};
+  TEST_ASSERT_TRUE(from_null == nullptr);
+
+  static_assert(!std::is_copy_constructible_v<malib::inplace_function<void()>>);
+  static_assert(
+      !std::is_constructible_v<malib::inplace_function<void()>, int>);
+}
+
+void test_InplaceFunction_move() {
+  auto owned = std::make_unique<int>(7);
+  malib::inplace_function<int(), 16> first{
+      [value = std::move(owned)] { return *value; }};
+  auto second = std::move(first);
+  TEST_ASSERT_TRUE(first == nullptr);
+  TEST_ASSERT_EQUAL(7, second());
+
+  {
+    malib::inplace_function<int(int)> wrapped{counted{}};
+    TEST_ASSERT_EQUAL(1, counted::alive);
+    malib::inplace_function<int(int)> moved{std::move(wrapped)};
+    TEST_ASSERT_EQUAL(1, counted::alive);
+    TEST_ASSERT_EQUAL(3, moved(2));
+    moved = nullptr;
+    TEST_ASSERT_EQUAL(0, counted::alive);
+    moved = malib::inplace_function<int(int)>{counted{}};
+    TEST_ASSERT_EQUAL(1, counted::alive);
+  }
+  TEST_ASSERT_EQUAL(0, counted::alive);
+}
+
+void test_FunctionRef() {
+  int calls = 0;
+  auto count = [&calls](std::string_view text) {
+    calls++;
+    return text.size();
+  };
+  malib::function_ref<std::size_t(std::string_view)> ref{count};
+  TEST_ASSERT_EQUAL(3, ref("abc"));
+  TEST_ASSERT_EQUAL(1, calls);
+
+  malib::function_ref<int(int)> function{twice};
+  TEST_ASSERT_EQUAL(6, function(3));
+
+  auto call = [](malib::function_ref<int(int)> fn) { return fn(5); };
+  TEST_ASSERT_EQUAL(6, call(counted{}));
+}
+
+void test_InplaceFunction() {
+  RUN_TEST(test_InplaceFunction_call);
+  RUN_TEST(test_InplaceFunction_empty);
+  RUN_TEST(test_InplaceFunction_move);
+  RUN_TEST(test_FunctionRef);
+}
@@ -1,5 +1,7 @@
 #include <unity.h>
 
+#include <memory>
+
 #include "malib/ObservableData.hpp"
 
 void test_no_subscribers() {
@@ -29,8 +31,25 @@ void test_multiple_subscribers() {
   TEST_ASSERT_EQUAL(42, data.get());
 }
 
+void test_move_only_subscriber() {
+  malib::ObservableData<int, 2> data{};
+  auto seen = std::make_shared<int>(0);
+  auto total = std::make_unique<int>(0);
+  auto* total_view = total.get();
+  data.subscribe([seen](auto& observed) { *seen = observed.get(); });
+  data.subscribe([total = std::move(total)](auto& observed) {
+    *total += observed.get();
+  });
+  data.subscribe([](auto&) { TEST_FAIL_MESSAGE("over capacity"); });
+  data.update(2);
+  data.update(3);
+  TEST_ASSERT_EQUAL(3, *seen);
+  TEST_ASSERT_EQUAL(5, *total_view);
+}
+
 void test_ObservableData() {
   RUN_TEST(test_no_subscribers);
   RUN_TEST(test_single_subscriber);
   RUN_TEST(test_multiple_subscribers);
+  RUN_TEST(test_move_only_subscriber);
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include <unity.h>
+
+#include <malib/ParallelTokenizer.hpp>
+#include <malib/Tokenizer.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+template <typename Parallel>
+std::vector<std::string_view> collect(const Parallel& parallel) {
+  std::vector<std::string_view> tokens{};
+  for (const auto& chunk : parallel.chunks()) {
+    for (auto token : chunk.views()) {
+      tokens.push_back(token);
+    }
+  }
+  return tokens;
+}
+
+template <malib::CharClassTable Classes>
+void assert_same_as_tokenizer(const std::string& input, std::size_t threads,
+                              std::size_t chunk_size) {
+  static malib::Tokenizer<4096, Classes, malib::WideToken> tokenizer{};
+  auto expected = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(expected.has_value());
+
+  malib::ParallelTokenizer<Classes> parallel{threads, chunk_size};
+  auto total = parallel.tokenize(input);
+  TEST_ASSERT_TRUE(total.has_value());
+  TEST_ASSERT_EQUAL(expected.value(), total.value());
+
+  auto tokens = collect(parallel);
+  TEST_ASSERT_EQUAL(expected.value(), tokens.size());
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    auto view = tokenizer[i]->view(input);
+    // Same position in the input, not just the same text
+    TEST_ASSERT_TRUE(view.data() == tokens[i].data());
+    TEST_ASSERT_EQUAL(view.size(), tokens[i].size());
+  }
+}
+}  // namespace
+
+void test_ParallelTokenizer_splits_at_newlines() {
+  const std::string input = "ls -al\necho hello world\nset key value\n";
+  malib::ParallelTokenizer<> parallel{2, 4};
+  auto total = parallel.tokenize(input);
+  TEST_ASSERT_TRUE(total.has_value());
+  TEST_ASSERT_EQUAL(8, total.value());
+  TEST_ASSERT_EQUAL(3, parallel.chunks().size());
+
+  auto first = parallel.chunks()[0].views();
+  TEST_ASSERT_EQUAL(2, first.size());
+  TEST_ASSERT_EQUAL_STRING_LEN("-al", first[1]->data(), 3);
+  TEST_ASSERT_EQUAL_STRING_LEN("ls -al\n", parallel.chunks()[0].input.data(),
+                               7);
+}
+
+void test_ParallelTokenizer_quotes_across_split() {
+  const std::string input =
+      "say \"first line\nsecond line\nthird\" done\nnext line\n";
+  malib::ParallelTokenizer<> parallel{4, 8};
+  auto total = parallel.tokenize(input);
+  TEST_ASSERT_TRUE(total.has_value());
+  TEST_ASSERT_EQUAL(5, total.value());
+
+  // The quoted region keeps its three lines in one chunk
+  auto tokens = collect(parallel);
+  TEST_ASSERT_EQUAL(30, tokens[1].size());
+  TEST_ASSERT_EQUAL_STRING_LEN("done", tokens[2].data(), 4);
+  TEST_ASSERT_EQUAL(2, parallel.chunks().size());
+}
+
+void test_ParallelTokenizer_escaped_newline() {
+  const std::string input = "a\\\nb c\nd \\\\\ne\n";
+  assert_same_as_tokenizer<malib::char_classes::shell_escaped>(input, 3, 1);
+}
+
+void test_ParallelTokenizer_matches_tokenizer() {
+  std::string input{};
+  for (int i = 0; i < 300; ++i) {
+    input += "cmd" + std::to_string(i) + " arg 'quoted value'";
+    if (i % 7 == 0) {
+      input += " \"spans\nlines " + std::to_string(i) + "\"";
+    }
+    if (i % 11 == 0) {
+      input += " it\\'s \\\"x";
+    }
+    input += "\n";
+  }
+
+  for (std::size_t chunk_size : {1, 16, 100, 1000, 100000}) {
+    assert_same_as_tokenizer<malib::char_classes::shell>(input, 4, chunk_size);
+    assert_same_as_tokenizer<malib::char_classes::shell_escaped>(input, 4,
+                                                                 chunk_size);
+  }
+}
+
+void test_ParallelTokenizer_token_too_long() {
+  const std::string input = "ok\n" + std::string(300, 'x') + "\nok\n";
+  malib::ParallelTokenizer<> parallel{2, 1};
+  auto total = parallel.tokenize(input);
+  TEST_ASSERT_FALSE(total.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange, total.error());
+
+  malib::ParallelTokenizer<malib::char_classes::shell, malib::WideToken> wide{
+      2, 1};
+  total = wide.tokenize(input);
+  TEST_ASSERT_TRUE(total.has_value());
+  TEST_ASSERT_EQUAL(3, total.value());
+}
+
+void test_ParallelTokenizer_empty_input() {
+  malib::ParallelTokenizer<> parallel{4};
+  auto total = parallel.tokenize("");
+  TEST_ASSERT_TRUE(total.has_value());
+  TEST_ASSERT_EQUAL(0, total.value());
+  TEST_ASSERT_EQUAL(0, parallel.chunks().size());
+}
+
+void test_ParallelTokenizer() {
+  RUN_TEST(test_ParallelTokenizer_splits_at_newlines);
+  RUN_TEST(test_ParallelTokenizer_quotes_across_split);
+  RUN_TEST(test_ParallelTokenizer_escaped_newline);
+  RUN_TEST(test_ParallelTokenizer_matches_tokenizer);
+  RUN_TEST(test_ParallelTokenizer_token_too_long);
+  RUN_TEST(test_ParallelTokenizer_empty_input);
+}
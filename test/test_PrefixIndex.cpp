@@ -0,0 +1,106 @@
+#include <unity.h>
+
+#include <malib/PrefixIndex.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+malib::PrefixIndex make_index() {
+  malib::PrefixIndex index{};
+  std::uint32_t value = 0;
+  for (std::string_view key : {"statistics", "status", "stat", "start", "help",
+                               "halt", "s"}) {
+    index.insert(key, value++);
+  }
+  return index;
+}
+
+std::string completions(const malib::PrefixIndex& index,
+                        std::string_view prefix) {
+  std::string result{};
+  index.complete(prefix, [&](std::string_view key, std::uint32_t) {
+    result += key;
+    result += ' ';
+  });
+  return result;
+}
+}  // namespace
+
+void test_PrefixIndex_find() {
+  auto index = make_index();
+  TEST_ASSERT_EQUAL(7, index.size());
+  TEST_ASSERT_EQUAL(0, index.find("statistics").value());
+  TEST_ASSERT_EQUAL(2, index.find("stat").value());
+  TEST_ASSERT_EQUAL(6, index.find("s").value());
+  TEST_ASSERT_EQUAL(5, index.find("halt").value());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, index.find("sta").error());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, index.find("stats").error());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, index.find("").error());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, index.find("x").error());
+}
+
+void test_PrefixIndex_insert() {
+  malib::PrefixIndex index{};
+  TEST_ASSERT_TRUE(index.empty());
+  TEST_ASSERT_EQUAL(malib::Error::EmptyInput, index.insert("", 1));
+
+  // Replacing a value keeps the key count
+  TEST_ASSERT_EQUAL(malib::Error::Ok, index.insert("reset", 1));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, index.insert("reset", 2));
+  TEST_ASSERT_EQUAL(1, index.size());
+  TEST_ASSERT_EQUAL(2, index.find("reset").value());
+
+  // Keys are copied, so the source may go away
+  {
+    std::string temporary = "read";
+    index.insert(temporary, 3);
+  }
+  TEST_ASSERT_EQUAL(3, index.find("read").value());
+  TEST_ASSERT_EQUAL(2, index.find("reset").value());
+}
+
+void test_PrefixIndex_resolve() {
+  auto index = make_index();
+
+  auto unique = index.resolve("stati");
+  TEST_ASSERT_TRUE(unique.has_value());
+  TEST_ASSERT_EQUAL_STRING_LEN("statistics", unique->key.data(), 10);
+  TEST_ASSERT_EQUAL(10, unique->key.size());
+  TEST_ASSERT_EQUAL(0, unique->value);
+
+  TEST_ASSERT_EQUAL(3, index.resolve("star").value().value);
+  TEST_ASSERT_EQUAL(1, index.resolve("statu").value().value);
+  TEST_ASSERT_EQUAL(5, index.resolve("ha").value().value);
+
+  // An exact key wins over the longer keys it starts
+  TEST_ASSERT_EQUAL(2, index.resolve("stat").value().value);
+  TEST_ASSERT_EQUAL(6, index.resolve("s").value().value);
+
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded,
+                    index.resolve("sta").error());
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded,
+                    index.resolve("h").error());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    index.resolve("stop").error());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, index.resolve("").error());
+}
+
+void test_PrefixIndex_complete() {
+  auto index = make_index();
+  TEST_ASSERT_EQUAL_STRING("stat statistics status ",
+                           completions(index, "stat").c_str());
+  TEST_ASSERT_EQUAL_STRING("s start stat statistics status ",
+                           completions(index, "s").c_str());
+  TEST_ASSERT_EQUAL_STRING("statistics ", completions(index, "stati").c_str());
+  TEST_ASSERT_EQUAL_STRING("", completions(index, "x").c_str());
+  TEST_ASSERT_EQUAL(7, index.complete("", [](auto, auto) {}));
+  TEST_ASSERT_EQUAL(2, index.complete("h", [](auto, auto) {}));
+}
+
+void test_PrefixIndex() {
+  RUN_TEST(test_PrefixIndex_find);
+  RUN_TEST(test_PrefixIndex_insert);
+  RUN_TEST(test_PrefixIndex_resolve);
+  RUN_TEST(test_PrefixIndex_complete);
+}
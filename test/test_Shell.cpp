@@ -1,6 +1,12 @@
 #include <unity.h>
 
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
 #include <iostream>
+#include <malib/ChainedBuffer.hpp>
+#include <malib/Format.hpp>
 #include <malib/Shell.hpp>
 #include <thread>
 
@@ -19,6 +25,20 @@ struct stub_output {
   }
 };
 
+struct appending_output {
+  std::string output{};
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    output.append(buf, size);
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    output.append(view);
+    return view.size();
+  }
+};
+
 void test_Shell_addCommand() {
   malib::shell::tiny shell{};
   shell.registerCommand("test", [](std::string_view command,
@@ -77,6 +97,14 @@ void test_Shell_emptyInput() {
   TEST_ASSERT_EQUAL_STRING("", output.output.c_str());
 }
 
+void test_Shell_whitespaceInput() {
+  malib::shell::tiny shell{};
+  stub_output output{};
+  auto result = shell.execute("   \t  ", output);
+  TEST_ASSERT_EQUAL(malib::Error::EmptyInput, result);
+  TEST_ASSERT_EQUAL_STRING("", output.output.c_str());
+}
+
 void test_Shell_nullCallback() {
   malib::shell::tiny shell{};
 
@@ -100,6 +128,14 @@ void test_Shell_malformedInput() {
   TEST_ASSERT_EQUAL(malib::Error::InvalidCommand, result);
 }
 
+void test_Shell_invalidCommandWithManyTokens() {
+  malib::shell::tiny<malib::FixedLengthLinearBuffer<char, 16>, 2> shell{};
+  stub_output output{};
+  // Unknown commands are rejected before the line is tokenized
+  auto result = shell.execute("nope a b c d e", output);
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand, result);
+}
+
 void test_Shell_emptyArguments() {
   malib::shell::tiny shell{};
   shell.registerCommand("test", [](std::string_view command,
@@ -270,13 +306,726 @@ void test_Shell_executeFromBuffer() {
   TEST_ASSERT_EQUAL_STRING("Hello", output.output.c_str());
 }
 
+void test_Shell_chainedOutputBuffer() {
+  using OutputBuffer = malib::ChainedBuffer<32, 16>;
+  malib::shell::tiny<OutputBuffer> shell{};
+  shell.registerCommand(
+      "dump",
+      [](std::string_view command, malib::shell::arguments args, auto& output) {
+        for (int i = 0; i < 40; i++) {
+          auto res = output.write("0123456789");
+          if (!res.has_value()) {
+            return res.error();
+          }
+        }
+        return malib::Error::Ok;
+      });
+
+  appending_output output{};
+  auto result = shell.execute("dump", output);
+  TEST_ASSERT_EQUAL(malib::Error::Ok, result);
+  TEST_ASSERT_EQUAL(400, output.output.size());
+  TEST_ASSERT_EQUAL_STRING_LEN("0123456789", output.output.c_str() + 390, 10);
+
+  // Segments go back to the pool once the output has been written
+  TEST_ASSERT_EQUAL(16, OutputBuffer::pool_type::shared().available());
+}
+
+void test_Shell_sessionsRunInParallel() {
+  malib::shell::tiny shell{};
+  std::atomic<int> inside{0};
+  shell.registerCommand(
+      "meet", [&inside](std::string_view command, malib::shell::arguments args,
+                        auto& output) {
+        inside++;
+        // Both callers have to be inside the callback at the same time
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (inside.load() < 2 &&
+               std::chrono::steady_clock::now() < deadline) {
+          std::this_thread::yield();
+        }
+        return output.write(std::to_string(inside.load()))
+            .error_or(malib::Error::Ok);
+      });
+
+  decltype(shell)::session_type session1{}, session2{};
+  stub_output output1{}, output2{};
+  std::thread t1([&]() { shell.execute(session1, "meet", output1); });
+  std::thread t2([&]() { shell.execute(session2, "meet", output2); });
+  t1.join();
+  t2.join();
+
+  TEST_ASSERT_EQUAL_STRING("2", output1.output.c_str());
+  TEST_ASSERT_EQUAL_STRING("2", output2.output.c_str());
+}
+
+void test_Shell_registerWhileExecuting() {
+  malib::shell::tiny shell{};
+  shell.registerCommand("echo", [](std::string_view command,
+                                   malib::shell::arguments args, auto& output) {
+    return output.write(args[0].value()).error_or(malib::Error::Ok);
+  });
+
+  static constexpr std::array<std::string_view, 4> names{"a", "b", "c", "d"};
+  std::atomic<bool> done{false};
+  std::thread registrar([&]() {
+    for (int i = 0; i < 200; i++) {
+      shell.registerCommand(
+          names[i % names.size()],
+          [i](std::string_view command, malib::shell::arguments args,
+              auto& output) { return malib::Error::Ok; });
+    }
+    done = true;
+  });
+
+  decltype(shell)::session_type session{};
+  int failures = 0;
+  do {
+    stub_output output{};
+    if (shell.execute(session, "echo hello", output) != malib::Error::Ok ||
+        output.output != "hello") {
+      failures++;
+    }
+  } while (!done.load());
+  registrar.join();
+
+  TEST_ASSERT_EQUAL(0, failures);
+  TEST_ASSERT_TRUE(shell.isCommandValid("d"));
+}
+
+void test_Shell_registerWhileReading() {
+  malib::shell::tiny shell{};
+  auto noop = [](std::string_view command, malib::shell::arguments args,
+                 auto& output) { return malib::Error::Ok; };
+  shell.registerCommand("first", noop);
+
+  // A reader holding the registry must not stall registration
+  std::size_t seen = 0;
+  shell.completeCommand("", [&](std::string_view name) {
+    seen++;
+    TEST_ASSERT_EQUAL(malib::Error::Ok, shell.registerCommand("second", noop));
+  });
+  TEST_ASSERT_EQUAL(1, seen);
+  TEST_ASSERT_TRUE(shell.isCommandValid("second"));
+}
+
+struct counting_output : appending_output {
+  int writes{0};
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    writes++;
+    return appending_output::write(buf, size);
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+
+// Accepts at most 3 bytes per call and nothing on every other call
+struct slow_output {
+  std::string output{};
+  int calls{0};
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    if (calls++ % 2 == 0) {
+      return std::unexpected(malib::Error::BufferFull);
+    }
+    auto accepted = std::min<std::size_t>(size, 3);
+    output.append(buf, accepted);
+    return accepted;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    return write(view.data(), view.size());
+  }
+};
+
+void test_Shell_streamingOutput() {
+  malib::shell::tiny<malib::shell::stream_writer<>> shell{};
+  counting_output* seen = nullptr;
+  shell.registerCommand(
+      "dump", [&seen](std::string_view command, malib::shell::arguments args,
+                      auto& output) {
+        for (int i = 0; i < 100; i++) {
+          auto res = output.write(std::string(100, 'a' + i % 26));
+          if (!res.has_value()) {
+            return res.error();
+          }
+        }
+        // Output reaches the caller while the command is still running
+        TEST_ASSERT_EQUAL(10000, seen->output.size());
+        return malib::Error::Ok;
+      });
+
+  counting_output output{};
+  seen = &output;
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("dump", output));
+  TEST_ASSERT_EQUAL(10000, output.output.size());
+  TEST_ASSERT_EQUAL(100, output.writes);
+  TEST_ASSERT_EQUAL('z', output.output[2599]);
+}
+
+void test_Shell_streamingCoalesce() {
+  malib::shell::tiny<malib::shell::stream_writer<64>> shell{};
+  shell.registerCommand("pairs", [](std::string_view command,
+                                    malib::shell::arguments args,
+                                    auto& output) {
+    for (int i = 0; i < 100; i++) {
+      output.write("ab");
+    }
+    // Larger writes bypass the coalescing buffer
+    output.write(std::string(100, 'c'));
+    output.write("d");
+    TEST_ASSERT_EQUAL(300, output.forwarded());
+    return malib::Error::Ok;
+  });
+
+  counting_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("pairs", output));
+  TEST_ASSERT_EQUAL(301, output.output.size());
+  // Three full buffers, the 8 byte rest, the large write and the final "d"
+  TEST_ASSERT_EQUAL(6, output.writes);
+  TEST_ASSERT_EQUAL_STRING_LEN("abab", output.output.c_str(), 4);
+  TEST_ASSERT_EQUAL('d', output.output.back());
+}
+
+void test_Shell_streamingBackpressure() {
+  malib::shell::tiny<malib::shell::stream_writer<16>> shell{};
+  shell.registerCommand("text", [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) {
+    for (auto arg : args) {
+      output.write(arg);
+    }
+    return malib::Error::Ok;
+  });
+
+  slow_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.execute("text hello streaming world", output));
+  TEST_ASSERT_EQUAL_STRING("hellostreamingworld", output.output.c_str());
+}
+
+void test_Shell_streamingStalledOutput() {
+  struct stalled_output {
+    std::expected<std::size_t, malib::Error> write(const char*, std::size_t) {
+      return 0;
+    }
+    std::expected<std::size_t, malib::Error> write(std::string_view) {
+      return 0;
+    }
+  };
+
+  malib::shell::tiny<malib::shell::stream_writer<0, 10>> shell{};
+  shell.registerCommand("dump", [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) {
+    auto res = output.write("data");
+    TEST_ASSERT_FALSE(res.has_value());
+    return res.error();
+  });
+
+  stalled_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::BufferFull, shell.execute("dump", output));
+}
+
+void test_Shell_streamingSlowOutput() {
+  // Accepts nothing for 50 ms, far more retries than a yield loop would make
+  struct paused_output {
+    std::chrono::steady_clock::time_point resume{};
+    std::string output{};
+    std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                   std::size_t size) {
+      if (std::chrono::steady_clock::now() < resume) {
+        return std::unexpected(malib::Error::BufferFull);
+      }
+      output.append(buf, size);
+      return size;
+    }
+    std::expected<std::size_t, malib::Error> write(std::string_view view) {
+      return write(view.data(), view.size());
+    }
+  };
+
+  malib::shell::tiny<malib::shell::stream_writer<>> shell{};
+  shell.registerCommand("dump", [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) {
+    return output.write("data").error_or(malib::Error::Ok);
+  });
+
+  paused_output output{std::chrono::steady_clock::now() +
+                       std::chrono::milliseconds{50}};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("dump", output));
+  TEST_ASSERT_EQUAL_STRING("data", output.output.c_str());
+}
+
+void test_Shell_streamingWaitHook() {
+  struct waitable_output {
+    bool writable{false};
+    int waits{0};
+    std::string output{};
+    std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                   std::size_t size) {
+      if (!writable) {
+        return 0;
+      }
+      output.append(buf, size);
+      return size;
+    }
+    std::expected<std::size_t, malib::Error> write(std::string_view view) {
+      return write(view.data(), view.size());
+    }
+    bool wait_writable(std::chrono::nanoseconds timeout) {
+      TEST_ASSERT_TRUE(timeout.count() > 0);
+      writable = ++waits == 3;
+      return writable;
+    }
+  };
+
+  malib::shell::tiny<malib::shell::stream_writer<>> shell{};
+  shell.registerCommand("dump", [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) {
+    return output.write("data").error_or(malib::Error::Ok);
+  });
+
+  waitable_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("dump", output));
+  TEST_ASSERT_EQUAL(3, output.waits);
+  TEST_ASSERT_EQUAL_STRING("data", output.output.c_str());
+}
+
+namespace {
+void register_text_commands(malib::shell::tiny<>& shell) {
+  shell.registerCommand("echo", [](std::string_view command,
+                                   malib::shell::arguments args, auto& output) {
+    for (std::size_t i = 0; i < args.size(); i++) {
+      output.write(args[i].value());
+      output.write(i + 1 < args.size() ? " " : "\n");
+    }
+    return malib::Error::Ok;
+  });
+  shell.registerCommand("upper", [](std::string_view command,
+                                    malib::shell::arguments args,
+                                    auto& output) {
+    for (auto arg : args) {
+      for (char c : arg) {
+        char u = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        output.write(&u, 1);
+      }
+      output.write(" ");
+    }
+    return malib::Error::Ok;
+  });
+  shell.registerCommand("count", [](std::string_view command,
+                                    malib::shell::arguments args,
+                                    auto& output) {
+    return output.write(std::to_string(args.size()) + "\n")
+        .error_or(malib::Error::Ok);
+  });
+  shell.registerCommand("fail", [](std::string_view command,
+                                   malib::shell::arguments args, auto& output) {
+    output.write("failed\n");
+    return malib::Error::InvalidArgument;
+  });
+}
+}  // namespace
+
+void test_Shell_script() {
+  malib::shell::tiny shell{};
+  register_text_commands(shell);
+
+  counting_output output{};
+  auto result = shell.executeScript(
+      "echo one two\n"
+      "\n"
+      "  # a comment\n"
+      "count a b c\r\n"
+      "echo three",
+      output);
+  TEST_ASSERT_EQUAL(malib::Error::Ok, result);
+  TEST_ASSERT_EQUAL_STRING("one two\n3\nthree\n", output.output.c_str());
+  // All lines are written at once
+  TEST_ASSERT_EQUAL(1, output.writes);
+}
+
+void test_Shell_pipeline() {
+  malib::shell::tiny shell{};
+  register_text_commands(shell);
+
+  counting_output output{};
+  auto result = shell.executeScript(
+      "echo a b | upper x | count\n"
+      "echo 'x|y' | upper",
+      output);
+  TEST_ASSERT_EQUAL(malib::Error::Ok, result);
+  // upper receives x, a and b; count receives X, A and B
+  TEST_ASSERT_EQUAL_STRING("3\n'X|Y' ", output.output.c_str());
+  TEST_ASSERT_EQUAL(1, output.writes);
+}
+
+void test_Shell_scriptStopOnError() {
+  malib::shell::tiny shell{};
+  register_text_commands(shell);
+
+  appending_output output{};
+  auto result = shell.executeScript(
+      "echo first\nfail | count\necho never", output);
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, result);
+  TEST_ASSERT_EQUAL_STRING("first\nfailed\n", output.output.c_str());
+
+  output.output.clear();
+  result = shell.executeScript("nope\necho after", output,
+                               malib::shell::on_error::resume);
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand, result);
+  TEST_ASSERT_EQUAL_STRING("Invalid command\nafter\n",
+                           output.output.c_str());
+}
+
+void test_Shell_prefixMatching() {
+  malib::shell::tiny shell{};
+  for (std::string_view name : {"statistics", "status", "start"}) {
+    shell.registerCommand(name, [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) {
+      return output.write(command).error_or(malib::Error::Ok);
+    });
+  }
+
+  stub_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.execute("stati", output));
+
+  shell.setPrefixMatching(true);
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("stati", output));
+  TEST_ASSERT_EQUAL_STRING("stati", output.output.c_str());
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("star now", output));
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.execute("sta", output));
+  TEST_ASSERT_EQUAL_STRING("Ambiguous command\n", output.output.c_str());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.execute("stop", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid command\n", output.output.c_str());
+}
+
+void test_Shell_completeCommand() {
+  malib::shell::tiny shell{};
+  for (std::string_view name : {"status", "statistics", "start", "help"}) {
+    shell.registerCommand(name, [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) { return malib::Error::Ok; });
+  }
+
+  std::string names{};
+  auto count = shell.completeCommand("sta", [&](std::string_view name) {
+    names += name;
+    names += ' ';
+  });
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL_STRING("start statistics status ", names.c_str());
+  TEST_ASSERT_EQUAL(0, shell.completeCommand("x", [](std::string_view) {}));
+}
+
+void test_Shell_stats() {
+  malib::shell::tiny<malib::FixedLengthLinearBuffer<char, 256>, 32, true>
+      shell{};
+  shell.registerCommand(
+      "echo", [](std::string_view, malib::shell::arguments args, auto& output) {
+        if (args.size() == 0) {
+          return malib::Error::InvalidArgument;
+        }
+        return output.write(*args[0]).error_or(malib::Error::Ok);
+      });
+
+  appending_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("echo hello", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("echo hi", output));
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("echo", output));
+
+  auto stats = shell.commandStats("echo");
+  TEST_ASSERT_TRUE(stats.has_value());
+  TEST_ASSERT_EQUAL(3, (*stats)->calls());
+  TEST_ASSERT_EQUAL(1, (*stats)->errors());
+  TEST_ASSERT_EQUAL(1, (*stats)->errors(malib::Error::InvalidArgument));
+  TEST_ASSERT_EQUAL(7, (*stats)->output_bytes());
+  TEST_ASSERT_EQUAL(3, (*stats)->dispatch.total());
+  TEST_ASSERT_EQUAL(3, (*stats)->callback.total());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.commandStats("missing").error());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("stats", output));
+  TEST_ASSERT_EQUAL_STRING(
+      "echo calls=3 errors=1 bytes=7\n"
+      "stats calls=0 errors=0 bytes=0\n",
+      output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("stats echo", output));
+  TEST_ASSERT_TRUE(output.output.starts_with(
+      "calls=3 errors=1 bytes=7\nerror 11 1\ndispatch "));
+  TEST_ASSERT_TRUE(output.output.find("\ncallback ") != std::string::npos);
+
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.execute("stats nope", output));
+}
+
+void test_Shell_statsDisabled() {
+  using shell_type = malib::shell::tiny<>;
+  static_assert(std::is_empty_v<shell_type::stats_type>);
+  struct without_stats {
+    std::string name;
+    shell_type::callback fn;
+    std::atomic<std::int64_t> cache_ttl;
+  };
+  static_assert(sizeof(shell_type::command_entry) == sizeof(without_stats));
+  shell_type shell{};
+  TEST_ASSERT_FALSE(shell.isCommandValid("stats"));
+}
+
+void test_Shell_typedCommand() {
+  malib::shell::tiny shell{};
+  shell.registerCommand("add", [](auto& output, int a, double b) {
+    return malib::format_to<"{}">(output, a + b).error_or(malib::Error::Ok);
+  });
+  shell.registerCommand(
+      "greet", [](malib::FixedLengthLinearBuffer<char, 256>& output,
+                  std::string_view name, std::string title) {
+        output.write(title);
+        return output.write(name).error_or(malib::Error::Ok);
+      });
+
+  appending_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("add 2 0.5", output));
+  TEST_ASSERT_EQUAL_STRING("2.5", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.execute("greet \"Ada L\" Dr\". \"", output));
+  TEST_ASSERT_EQUAL_STRING("Dr. Ada L", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("add 1", output));
+  TEST_ASSERT_EQUAL_STRING("Expected 2 arguments\n", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("add 1 x", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid argument 2\n", output.output.c_str());
+
+  // Numbers must span the whole token
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("add 1x 2.9", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid argument 1\n", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("add 2.9 1", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid argument 1\n", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("add 1 0.5s", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid argument 2\n", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange,
+                    shell.execute("add 99999999999 1", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid argument 1\n", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("greet a\"b c\" x", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid argument 1\n", output.output.c_str());
+}
+
+void test_Shell_responseCache() {
+  malib::shell::tiny shell{};
+  int calls = 0;
+  shell.registerCommand("status", [&](std::string_view,
+                                      malib::shell::arguments args,
+                                      auto& output) {
+    calls++;
+    output.write("up ");
+    for (auto arg : args) {
+      output.write(arg);
+    }
+    return malib::Error::Ok;
+  });
+
+  appending_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.setCommandCaching("status", std::chrono::hours{1}));
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.setCommandCaching("nope", std::chrono::hours{1}));
+
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("  status   a ", output));
+  shell.setPrefixMatching(true);
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("stat a", output));
+  TEST_ASSERT_EQUAL(1, calls);
+  TEST_ASSERT_EQUAL_STRING("up aup aup a", output.output.c_str());
+
+  // Other arguments are other entries
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status b", output));
+  TEST_ASSERT_EQUAL(2, calls);
+
+  shell.invalidateCache("status");
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  TEST_ASSERT_EQUAL(3, calls);
+  shell.invalidateCache();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  TEST_ASSERT_EQUAL(4, calls);
+
+  // Expired output is not used
+  shell.setCommandCaching("status", std::chrono::nanoseconds{1});
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  TEST_ASSERT_EQUAL(6, calls);
+
+  shell.setCommandCaching("status", std::chrono::nanoseconds{0});
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status a", output));
+  TEST_ASSERT_EQUAL(8, calls);
+}
+
+void test_Shell_responseCacheErrors() {
+  malib::shell::tiny shell{};
+  int calls = 0;
+  shell.registerCommand("flaky", [&](std::string_view,
+                                     malib::shell::arguments, auto& output) {
+    output.write("x");
+    return ++calls == 1 ? malib::Error::InvalidArgument : malib::Error::Ok;
+  });
+  shell.setCommandCaching("flaky", std::chrono::hours{1});
+
+  appending_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("flaky", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("flaky", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("flaky", output));
+  TEST_ASSERT_EQUAL(2, calls);
+  TEST_ASSERT_EQUAL_STRING("xxx", output.output.c_str());
+
+  // Replacing the command keeps it cached but drops its output
+  shell.registerCommand("flaky", [&](std::string_view,
+                                     malib::shell::arguments, auto& output) {
+    calls += 10;
+    return output.write("new").error_or(malib::Error::Ok);
+  });
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("flaky", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("flaky", output));
+  TEST_ASSERT_EQUAL(12, calls);
+  TEST_ASSERT_EQUAL_STRING("xxxnewnew", output.output.c_str());
+}
+
+void test_Shell_responseCacheCapacity() {
+  malib::shell::response_cache cache{2};
+  cache.store("a", "1", std::chrono::hours{1}, cache.generation());
+  cache.store("b", "2", std::chrono::nanoseconds{1}, cache.generation());
+  std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  cache.store("c", "3", std::chrono::hours{1}, cache.generation());
+  cache.store("d", "4", std::chrono::hours{1}, cache.generation());
+  TEST_ASSERT_EQUAL(2, cache.size());
+  TEST_ASSERT_EQUAL_STRING("1", cache.find("a")->c_str());
+  TEST_ASSERT_EQUAL_STRING("3", cache.find("c")->c_str());
+  TEST_ASSERT_NULL(cache.find("d"));
+
+  cache.invalidate();
+  cache.store(std::string_view{"a\0x", 3}, "5", std::chrono::hours{1},
+              cache.generation());
+  cache.store("ab", "6", std::chrono::hours{1}, cache.generation());
+  cache.invalidate("a");
+  TEST_ASSERT_NULL(cache.find("a"));
+  TEST_ASSERT_NULL(cache.find(std::string_view{"a\0x", 3}));
+  TEST_ASSERT_NOT_NULL(cache.find("ab"));
+
+  // Output produced across an invalidation is dropped
+  const auto generation = cache.generation();
+  cache.invalidate("x");
+  cache.store("late", "7", std::chrono::hours{1}, generation);
+  TEST_ASSERT_NULL(cache.find("late"));
+}
+
+void test_Shell_responseCacheStaleOutput() {
+  malib::shell::tiny shell{};
+  int calls = 0;
+  bool invalidate = true;
+  shell.registerCommand("status", [&](std::string_view, malib::shell::arguments,
+                                      auto& output) {
+    calls++;
+    // Stands in for an invalidation by another thread while this runs
+    if (invalidate) {
+      shell.invalidateCache();
+    }
+    return output.write("up").error_or(malib::Error::Ok);
+  });
+  shell.setCommandCaching("status", std::chrono::hours{1});
+
+  appending_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", output));
+  TEST_ASSERT_EQUAL(2, calls);
+
+  invalidate = false;
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", output));
+  TEST_ASSERT_EQUAL(3, calls);
+}
+
+void test_Shell_responseCacheShortWrite() {
+  // Accepts at most limit bytes in total
+  struct limited_output {
+    std::string output{};
+    std::size_t limit;
+    std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                   std::size_t size) {
+      size = std::min(size, limit - output.size());
+      output.append(buf, size);
+      return size;
+    }
+    std::expected<std::size_t, malib::Error> write(std::string_view view) {
+      return write(view.data(), view.size());
+    }
+  };
+
+  malib::shell::tiny shell{};
+  int calls = 0;
+  shell.registerCommand("status", [&](std::string_view, malib::shell::arguments,
+                                      auto& output) {
+    calls++;
+    return output.write("all good").error_or(malib::Error::Ok);
+  });
+  shell.setCommandCaching("status", std::chrono::hours{1});
+
+  limited_output partial{.limit = 3};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", partial));
+  TEST_ASSERT_EQUAL_STRING("all", partial.output.c_str());
+
+  // The cut output was not cached, so the next caller gets all of it
+  appending_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("status", output));
+  TEST_ASSERT_EQUAL(2, calls);
+  TEST_ASSERT_EQUAL_STRING("all goodall good", output.output.c_str());
+}
+
 void test_Shell() {
   RUN_TEST(test_Shell_addCommand);
   RUN_TEST(test_Shell_execute);
   RUN_TEST(test_Shell_invalidCommand);
   RUN_TEST(test_Shell_emptyInput);
+  RUN_TEST(test_Shell_whitespaceInput);
   RUN_TEST(test_Shell_nullCallback);
   RUN_TEST(test_Shell_malformedInput);
+  RUN_TEST(test_Shell_invalidCommandWithManyTokens);
   RUN_TEST(test_Shell_emptyArguments);
   RUN_TEST(test_Shell_bufferOverflow);
   RUN_TEST(test_Shell_threadSafety);
@@ -286,4 +1035,27 @@ void test_Shell() {
   RUN_TEST(test_Shell_outputBufferOverflow);
   RUN_TEST(test_Shell_commandFailureWithOutput);
   RUN_TEST(test_Shell_executeFromBuffer);
+  RUN_TEST(test_Shell_chainedOutputBuffer);
+  RUN_TEST(test_Shell_sessionsRunInParallel);
+  RUN_TEST(test_Shell_registerWhileExecuting);
+  RUN_TEST(test_Shell_registerWhileReading);
+  RUN_TEST(test_Shell_streamingOutput);
+  RUN_TEST(test_Shell_streamingCoalesce);
+  RUN_TEST(test_Shell_streamingBackpressure);
+  RUN_TEST(test_Shell_streamingStalledOutput);
+  RUN_TEST(test_Shell_streamingSlowOutput);
+  RUN_TEST(test_Shell_streamingWaitHook);
+  RUN_TEST(test_Shell_script);
+  RUN_TEST(test_Shell_pipeline);
+  RUN_TEST(test_Shell_scriptStopOnError);
+  RUN_TEST(test_Shell_prefixMatching);
+  RUN_TEST(test_Shell_completeCommand);
+  RUN_TEST(test_Shell_stats);
+  RUN_TEST(test_Shell_statsDisabled);
+  RUN_TEST(test_Shell_typedCommand);
+  RUN_TEST(test_Shell_responseCache);
+  RUN_TEST(test_Shell_responseCacheErrors);
+  RUN_TEST(test_Shell_responseCacheCapacity);
+  RUN_TEST(test_Shell_responseCacheStaleOutput);
+  RUN_TEST(test_Shell_responseCacheShortWrite);
 }
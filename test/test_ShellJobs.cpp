@@ -0,0 +1,245 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <malib/Shell.hpp>
+#include <malib/ShellJobs.hpp>
+#include <string>
+#include <thread>
+
+namespace {
+struct string_output {
+  std::string output{};
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    output.append(buf, size);
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    output.append(view);
+    return view.size();
+  }
+};
+
+using shell_type = malib::shell::tiny<>;
+using pool_type = malib::shell::job_pool<shell_type, 64>;
+
+bool wait_for(const pool_type& pool, std::size_t id,
+              malib::shell::job_state state) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (pool.state(id) == state) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+bool wait_until_ended(const pool_type& pool, std::size_t id) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto state = pool.state(id);
+    if (state == malib::shell::job_state::done ||
+        state == malib::shell::job_state::cancelled) {
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  return false;
+}
+}  // namespace
+
+void test_ShellJobs_runAndWait() {
+  shell_type shell{};
+  pool_type pool{shell, 2};
+  std::atomic<bool> go{false};
+  pool.registerCommand("sum", [&go](std::string_view command,
+                                    malib::shell::arguments args,
+                                    auto& output) {
+    while (!go) {
+      std::this_thread::yield();
+    }
+    int total = 0;
+    for (auto arg : args) {
+      int value = 0;
+      malib::StringConverter::to_number(arg, value);
+      total += value;
+      output.write("+");
+    }
+    output.write(std::to_string(total));
+    return malib::Error::Ok;
+  });
+
+  string_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("sum 1 2 \"3\"", output));
+  TEST_ASSERT_EQUAL_STRING("[1]\n", output.output.c_str());
+  TEST_ASSERT_TRUE(wait_for(pool, 1, malib::shell::job_state::running));
+
+  // wait does not block on a running job, it reports its state
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("wait 1", output));
+  TEST_ASSERT_EQUAL_STRING("running\n", output.output.c_str());
+
+  go = true;
+  TEST_ASSERT_TRUE(wait_for(pool, 1, malib::shell::job_state::done));
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("wait 1", output));
+  // The quoted argument keeps its quotes and does not convert
+  TEST_ASSERT_EQUAL_STRING("+++3", output.output.c_str());
+
+  // Waited jobs are forgotten
+  TEST_ASSERT_FALSE(pool.state(1).has_value());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("wait 1", output));
+}
+
+void test_ShellJobs_cancel() {
+  shell_type shell{};
+  pool_type pool{shell, 1};
+  std::atomic<bool> started{false};
+  pool.registerCommand("spin", [&started](std::string_view command,
+                                          malib::shell::arguments args,
+                                          auto& output) {
+    started = true;
+    while (!output.stop_requested()) {
+      std::this_thread::yield();
+    }
+    output.write("stopped");
+    return malib::Error::Ok;
+  });
+
+  string_output output{};
+  shell.execute("spin", output);
+  shell.execute("spin", output);
+  TEST_ASSERT_EQUAL_STRING("[1]\n[2]\n", output.output.c_str());
+  TEST_ASSERT_TRUE(wait_for(pool, 1, malib::shell::job_state::running));
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("jobs", output));
+  TEST_ASSERT_EQUAL_STRING("1 running spin\n2 queued spin\n",
+                           output.output.c_str());
+
+  // The queued job never starts
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("cancel 2", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("cancel 1", output));
+  TEST_ASSERT_TRUE(wait_until_ended(pool, 1));
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("wait 1", output));
+  TEST_ASSERT_EQUAL_STRING("stopped", output.output.c_str());
+  TEST_ASSERT_TRUE(wait_for(pool, 2, malib::shell::job_state::cancelled));
+
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("cancel x", output));
+  // Ids must be whole numbers, not a number followed by junk
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("wait 2abc", output));
+  TEST_ASSERT_EQUAL(malib::shell::job_state::cancelled, pool.state(2).value());
+}
+
+void test_ShellJobs_waitWhileCancelling() {
+  shell_type shell{};
+  pool_type pool{shell, 1};
+  pool.registerCommand("spin", [](std::string_view command,
+                                  malib::shell::arguments args, auto& output) {
+    while (!output.stop_requested()) {
+      std::this_thread::yield();
+    }
+    output.write("stopped");
+    return malib::Error::Ok;
+  });
+
+  string_output output{};
+  shell.execute("spin", output);
+  TEST_ASSERT_TRUE(wait_for(pool, 1, malib::shell::job_state::running));
+
+  // Both commands run on the shared session; a blocking wait would keep
+  // cancel from ever running
+  std::atomic<bool> collected{false};
+  std::string waited{};
+  std::thread waiter([&] {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+      string_output polled{};
+      if (shell.execute("wait 1", polled) != malib::Error::Ok) {
+        return;
+      }
+      if (polled.output != "running\n") {
+        waited = polled.output;
+        collected = true;
+        return;
+      }
+      std::this_thread::yield();
+    }
+  });
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("cancel 1", output));
+  waiter.join();
+
+  TEST_ASSERT_TRUE(collected.load());
+  TEST_ASSERT_EQUAL_STRING("stopped", waited.c_str());
+  TEST_ASSERT_FALSE(pool.state(1).has_value());
+}
+
+void test_ShellJobs_progressRing() {
+  shell_type shell{};
+  pool_type pool{shell, 1};
+  pool.registerCommand("chatty", [](std::string_view command,
+                                    malib::shell::arguments args,
+                                    auto& output) {
+    for (int i = 0; i < 100; i++) {
+      output.write(std::to_string(i % 10));
+    }
+    return malib::Error::ResultOutOfRange;
+  });
+
+  string_output output{};
+  shell.execute("chatty", output);
+  TEST_ASSERT_TRUE(wait_for(pool, 1, malib::shell::job_state::done));
+  output.output.clear();
+  // The job result is the result of wait; only the last 64 bytes are kept
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange,
+                    shell.execute("wait 1", output));
+  TEST_ASSERT_EQUAL(64, output.output.size());
+  TEST_ASSERT_EQUAL('9', output.output.back());
+}
+
+void test_ShellJobs_finishedHistory() {
+  shell_type shell{};
+  pool_type pool{shell, 1, 2};
+  pool.registerCommand("noop", [](std::string_view command,
+                                  malib::shell::arguments args,
+                                  auto& output) { return malib::Error::Ok; });
+
+  string_output output{};
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("noop", output));
+  }
+  TEST_ASSERT_TRUE(wait_for(pool, 5, malib::shell::job_state::done));
+
+  // Only the two most recent jobs nobody waited for are kept
+  for (std::size_t id = 1; id <= 3; id++) {
+    TEST_ASSERT_FALSE(pool.state(id).has_value());
+  }
+  TEST_ASSERT_EQUAL(malib::shell::job_state::done, pool.state(4).value());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("jobs", output));
+  TEST_ASSERT_EQUAL_STRING("4 done noop\n5 done noop\n",
+                           output.output.c_str());
+
+  // Waiting frees a slot, so a new job does not displace job 5
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("wait 4", output));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("noop", output));
+  TEST_ASSERT_TRUE(wait_for(pool, 6, malib::shell::job_state::done));
+  TEST_ASSERT_EQUAL(malib::shell::job_state::done, pool.state(5).value());
+}
+
+void test_ShellJobs() {
+  RUN_TEST(test_ShellJobs_runAndWait);
+  RUN_TEST(test_ShellJobs_cancel);
+  RUN_TEST(test_ShellJobs_waitWhileCancelling);
+  RUN_TEST(test_ShellJobs_progressRing);
+  RUN_TEST(test_ShellJobs_finishedHistory);
+}
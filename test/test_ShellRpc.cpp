@@ -0,0 +1,177 @@
+#include <unity.h>
+
+#include <array>
+#include <malib/Format.hpp>
+#include <malib/ShellRpc.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+struct string_output {
+  std::string output{};
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    output.append(buf, size);
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    output.append(view);
+    return view.size();
+  }
+};
+
+using shell_type = malib::shell::tiny<>;
+
+void register_commands(shell_type& shell) {
+  shell.registerCommand("add", [](auto& output, int a, int b) {
+    return malib::format_to<"{}">(output, a + b).error_or(malib::Error::Ok);
+  });
+  shell.registerCommand("echo", [](std::string_view command,
+                                   malib::shell::arguments args,
+                                   auto& output) {
+    output.write(command);
+    for (auto arg : args) {
+      output.write(":");
+      output.write(arg);
+    }
+    return malib::Error::Ok;
+  });
+}
+
+std::string request(std::uint32_t id, std::uint32_t command,
+                    std::vector<std::string_view> args) {
+  std::array<char, 256> frame{};
+  auto size = malib::shell::rpc::encode_request(frame, id, command, args);
+  return std::string{frame.data(), size.value()};
+}
+}  // namespace
+
+void test_ShellRpc_pipelined() {
+  shell_type shell{};
+  register_commands(shell);
+  const auto add = shell.commandId("add").value();
+  const auto echo = shell.commandId("echo").value();
+
+  std::string stream = request(7, add, {"2", "40"}) +
+                       request(8, echo, {"a b", std::string_view{"\0x", 2}}) +
+                       request(9, add, {"1"});
+  malib::shell::rpc_channel<shell_type> channel{shell};
+  string_output output{};
+  auto consumed = channel.process(stream, output);
+  TEST_ASSERT_EQUAL(stream.size(), consumed.value());
+
+  std::string_view responses = output.output;
+  auto first = malib::shell::rpc::decode_response(responses).value();
+  TEST_ASSERT_EQUAL(7, first.id);
+  TEST_ASSERT_EQUAL(malib::Error::Ok, first.result);
+  TEST_ASSERT_EQUAL_STRING("42", std::string{first.output}.c_str());
+
+  responses.remove_prefix(first.frame_size);
+  auto second = malib::shell::rpc::decode_response(responses).value();
+  TEST_ASSERT_EQUAL(8, second.id);
+  TEST_ASSERT_TRUE(second.output == std::string_view("echo:a b:\0x", 11));
+
+  responses.remove_prefix(second.frame_size);
+  auto third = malib::shell::rpc::decode_response(responses).value();
+  TEST_ASSERT_EQUAL(9, third.id);
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, third.result);
+  TEST_ASSERT_EQUAL_STRING("Expected 2 arguments\n",
+                           std::string{third.output}.c_str());
+  TEST_ASSERT_EQUAL(third.frame_size, responses.size());
+}
+
+void test_ShellRpc_partialFrames() {
+  shell_type shell{};
+  register_commands(shell);
+  const std::string frame = request(1, shell.commandId("add").value(),
+                                    {"1", "2"});
+  malib::shell::rpc_channel<shell_type> channel{shell};
+  string_output output{};
+
+  std::string received{};
+  for (char c : frame) {
+    received.push_back(c);
+    auto consumed = channel.process(received, output);
+    TEST_ASSERT_TRUE(consumed.has_value());
+    received.erase(0, *consumed);
+  }
+  TEST_ASSERT_TRUE(received.empty());
+  auto response = malib::shell::rpc::decode_response(output.output).value();
+  TEST_ASSERT_EQUAL_STRING("3", std::string{response.output}.c_str());
+  TEST_ASSERT_EQUAL(malib::Error::BufferEmpty,
+                    malib::shell::rpc::decode_response(
+                        std::string_view{output.output}.substr(0, 5))
+                        .error());
+}
+
+void test_ShellRpc_errors() {
+  shell_type shell{};
+  register_commands(shell);
+  malib::shell::rpc_channel<shell_type, 64> channel{shell};
+  string_output output{};
+
+  // Unknown command id
+  auto unknown = request(3, 99, {});
+  TEST_ASSERT_EQUAL(unknown.size(), channel.process(unknown, output).value());
+  auto response = malib::shell::rpc::decode_response(output.output).value();
+  TEST_ASSERT_EQUAL(3, response.id);
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand, response.result);
+
+  // An argument that runs past the end of its frame
+  output.output.clear();
+  auto truncated = request(4, shell.commandId("echo").value(), {"abc"});
+  truncated[0] = static_cast<char>(truncated[0] - 1);
+  truncated.pop_back();
+  TEST_ASSERT_EQUAL(truncated.size(),
+                    channel.process(truncated, output).value());
+  response = malib::shell::rpc::decode_response(output.output).value();
+  TEST_ASSERT_EQUAL(4, response.id);
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, response.result);
+
+  // Frames larger than the channel accepts
+  output.output.clear();
+  auto large = request(5, 0, {std::string(100, 'x')});
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded,
+                    channel.process(large, output).error());
+
+  std::array<char, 8> small{};
+  TEST_ASSERT_EQUAL(malib::Error::BufferFull,
+                    malib::shell::rpc::encode_request(small, 1, 0, {}).error());
+  const std::string long_text(300, 'x');
+  std::array<std::string_view, 1> long_argument{long_text};
+  std::array<char, 512> frame{};
+  TEST_ASSERT_EQUAL(
+      malib::Error::MaximumSizeExceeded,
+      malib::shell::rpc::encode_request(frame, 1, 0, long_argument).error());
+}
+
+void test_ShellRpc_commandId() {
+  shell_type shell{};
+  register_commands(shell);
+  const auto echo = shell.commandId("echo").value();
+  shell.registerCommand("zzz", [](std::string_view, malib::shell::arguments,
+                                  auto&) { return malib::Error::Ok; });
+  shell.registerCommand("echo", [](std::string_view, malib::shell::arguments,
+                                   auto& output) {
+    return output.write("new").error_or(malib::Error::Ok);
+  });
+  TEST_ASSERT_EQUAL(echo, shell.commandId("echo").value());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.commandId("ech").error());
+
+  shell_type::session_type session{};
+  string_output output{};
+  auto none = malib::shell::arguments::create("", {}).value();
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.call(session, echo, none, output));
+  TEST_ASSERT_EQUAL_STRING("new", output.output.c_str());
+}
+
+void test_ShellRpc() {
+  RUN_TEST(test_ShellRpc_pipelined);
+  RUN_TEST(test_ShellRpc_partialFrames);
+  RUN_TEST(test_ShellRpc_errors);
+  RUN_TEST(test_ShellRpc_commandId);
+}
@@ -0,0 +1,247 @@
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <array>
+#include <malib/Shell.hpp>
+#include <malib/ShellServer.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using shell_type = malib::shell::tiny<>;
+using server_type = malib::shell::server<shell_type, 64, 256>;
+
+void register_commands(shell_type& shell) {
+  shell.registerCommand("echo", [](std::string_view command,
+                                   malib::shell::arguments args, auto& output) {
+    for (auto arg : args) {
+      output.write(arg);
+    }
+    return output.write("\n").error_or(malib::Error::Ok);
+  });
+  shell.registerCommand("fill", [](std::string_view command,
+                                   malib::shell::arguments args, auto& output) {
+    return output.write(std::string(128, 'x')).error_or(malib::Error::Ok);
+  });
+}
+
+// Returns the client end of a socketpair whose other end the server serves
+int connect(server_type& server) {
+  std::array<int, 2> fds{};
+  TEST_ASSERT_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+  TEST_ASSERT_EQUAL(malib::Error::Ok, server.add(fds[1]));
+  return fds[0];
+}
+
+void send_text(int fd, std::string_view text) {
+  TEST_ASSERT_EQUAL(text.size(), ::write(fd, text.data(), text.size()));
+}
+
+std::string receive_text(int fd) {
+  std::array<char, 1024> buffer{};
+  const auto count = ::recv(fd, buffer.data(), buffer.size(), MSG_DONTWAIT);
+  return count > 0 ? std::string(buffer.data(), count) : std::string{};
+}
+
+void serve(server_type& server, int rounds = 3) {
+  for (int i = 0; i < rounds; i++) {
+    server.poll(10);
+  }
+}
+}  // namespace
+
+void test_ShellServer_lines() {
+  shell_type shell{};
+  register_commands(shell);
+  auto server = server_type::create(shell);
+  TEST_ASSERT_TRUE(server.has_value());
+
+  int client = connect(*server);
+  // Two lines in one write, then a line split over two writes
+  send_text(client, "echo a b\r\necho c\n");
+  serve(*server);
+  TEST_ASSERT_EQUAL_STRING("ab\nc\n", receive_text(client).c_str());
+
+  send_text(client, "ech");
+  serve(*server);
+  TEST_ASSERT_EQUAL_STRING("", receive_text(client).c_str());
+  send_text(client, "o d\nnope\n");
+  serve(*server);
+  TEST_ASSERT_EQUAL_STRING("d\nInvalid command\n",
+                           receive_text(client).c_str());
+  ::close(client);
+}
+
+void test_ShellServer_manySessions() {
+  shell_type shell{};
+  register_commands(shell);
+  auto server = server_type::create(shell);
+
+  std::vector<int> clients{};
+  for (int i = 0; i < 500; i++) {
+    clients.push_back(connect(*server));
+  }
+  TEST_ASSERT_EQUAL(500, server->sessions());
+
+  for (int i = 0; i < 500; i += 7) {
+    send_text(clients[i], "echo " + std::to_string(i) + "\n");
+  }
+  serve(*server, 20);
+  for (int i = 0; i < 500; i++) {
+    auto expected = i % 7 == 0 ? std::to_string(i) + "\n" : std::string{};
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(),
+                             receive_text(clients[i]).c_str());
+  }
+
+  // Hang-ups close their sessions
+  for (int i = 0; i < 250; i++) {
+    ::close(clients[i]);
+  }
+  serve(*server, 10);
+  TEST_ASSERT_EQUAL(250, server->sessions());
+  for (int i = 250; i < 500; i++) {
+    ::close(clients[i]);
+  }
+}
+
+void test_ShellServer_backpressure() {
+  shell_type shell{};
+  register_commands(shell);
+  auto server = server_type::create(shell);
+  int client = connect(*server);
+
+  int size = 4096;
+  ::setsockopt(client, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+  // Far more output than the socket and the output ring hold at once
+  std::string commands{};
+  for (int i = 0; i < 40; i++) {
+    commands += "fill\n";
+  }
+  send_text(client, commands);
+
+  std::string received{};
+  for (int i = 0; i < 1000 && received.size() < 40 * 128; i++) {
+    server->poll(1);
+    received += receive_text(client);
+  }
+  TEST_ASSERT_EQUAL(40 * 128, received.size());
+  ::close(client);
+}
+
+void test_ShellServer_longLine() {
+  shell_type shell{};
+  register_commands(shell);
+  auto server = server_type::create(shell);
+  int client = connect(*server);
+
+  send_text(client, "echo " + std::string(100, 'y') + "\necho ok\n");
+  serve(*server);
+  TEST_ASSERT_EQUAL_STRING("Line too long\nok\n",
+                           receive_text(client).c_str());
+  ::close(client);
+}
+
+void test_ShellServer_listen() {
+  shell_type shell{};
+  register_commands(shell);
+  auto server = server_type::create(shell);
+
+  const std::string path =
+      "/tmp/malib_shell_" + std::to_string(::getpid()) + ".sock";
+  ::unlink(path.c_str());
+  TEST_ASSERT_EQUAL(malib::Error::Ok, server->listen(path));
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded,
+                    server->listen(std::string(200, 'p')));
+
+  int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::copy(path.begin(), path.end(), address.sun_path);
+  TEST_ASSERT_EQUAL(0, ::connect(client,
+                                 reinterpret_cast<const sockaddr*>(&address),
+                                 sizeof(address)));
+
+  send_text(client, "echo hi\n");
+  serve(*server);
+  TEST_ASSERT_EQUAL(1, server->sessions());
+  TEST_ASSERT_EQUAL_STRING("hi\n", receive_text(client).c_str());
+
+  // run() returns once stopped from another thread
+  std::thread stopper([&]() { server->stop(); });
+  TEST_ASSERT_EQUAL(malib::Error::Ok, server->run());
+  stopper.join();
+
+  ::close(client);
+  ::unlink(path.c_str());
+}
+
+void test_ShellServer_outOfDescriptors() {
+  shell_type shell{};
+  register_commands(shell);
+  auto server = server_type::create(shell);
+
+  const std::string path =
+      "/tmp/malib_shell_emfile_" + std::to_string(::getpid()) + ".sock";
+  ::unlink(path.c_str());
+  TEST_ASSERT_EQUAL(malib::Error::Ok, server->listen(path));
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::copy(path.begin(), path.end(), address.sun_path);
+  std::array<int, 2> clients{};
+  for (auto& client : clients) {
+    client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    TEST_ASSERT_EQUAL(
+        0, ::connect(client, reinterpret_cast<const sockaddr*>(&address),
+                     sizeof(address)));
+  }
+
+  // Allow no descriptor beyond the lowest free one, then take that one too
+  rlimit limit{};
+  TEST_ASSERT_EQUAL(0, ::getrlimit(RLIMIT_NOFILE, &limit));
+  const int last = ::open("/dev/null", O_RDONLY);
+  rlimit lowered = limit;
+  lowered.rlim_cur = static_cast<rlim_t>(last) + 1;
+  TEST_ASSERT_EQUAL(0, ::setrlimit(RLIMIT_NOFILE, &lowered));
+
+  // Both pending connections are turned away instead of waking every poll
+  auto handled = server->poll(10);
+  TEST_ASSERT_TRUE(handled.has_value());
+  TEST_ASSERT_EQUAL(1, handled.value());
+  TEST_ASSERT_EQUAL(0, server->sessions());
+  TEST_ASSERT_EQUAL(0, server->poll(0).value());
+
+  ::close(last);
+  TEST_ASSERT_EQUAL(0, ::setrlimit(RLIMIT_NOFILE, &limit));
+  for (int client : clients) {
+    std::array<char, 8> buffer{};
+    TEST_ASSERT_EQUAL(0, ::recv(client, buffer.data(), buffer.size(), 0));
+    ::close(client);
+  }
+
+  // Once descriptors are available again connections are served
+  int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  TEST_ASSERT_EQUAL(0, ::connect(client,
+                                 reinterpret_cast<const sockaddr*>(&address),
+                                 sizeof(address)));
+  send_text(client, "echo ok\n");
+  serve(*server);
+  TEST_ASSERT_EQUAL_STRING("ok\n", receive_text(client).c_str());
+  ::close(client);
+  ::unlink(path.c_str());
+}
+
+void test_ShellServer() {
+  RUN_TEST(test_ShellServer_lines);
+  RUN_TEST(test_ShellServer_manySessions);
+  RUN_TEST(test_ShellServer_backpressure);
+  RUN_TEST(test_ShellServer_longLine);
+  RUN_TEST(test_ShellServer_listen);
+  RUN_TEST(test_ShellServer_outOfDescriptors);
+}
@@ -0,0 +1,171 @@
+#include <unity.h>
+
+#include <malib/FixedStringBuffer.hpp>
+#include <malib/Format.hpp>
+#include <malib/PerfectHash.hpp>
+#include <malib/StaticShell.hpp>
+#include <string>
+
+namespace {
+struct string_output {
+  std::string output{};
+  std::expected<std::size_t, malib::Error> write(const char* buf,
+                                                 std::size_t size) {
+    output.append(buf, size);
+    return size;
+  }
+
+  std::expected<std::size_t, malib::Error> write(std::string_view view) {
+    output.append(view);
+    return view.size();
+  }
+};
+
+malib::Error echo(std::string_view, malib::shell::arguments args,
+                  malib::FixedLengthLinearBuffer<char, 256>& output) {
+  for (auto arg : args) {
+    auto res = output.write(arg.data(), arg.size());
+    if (!res.has_value()) {
+      return res.error();
+    }
+  }
+  return malib::Error::Ok;
+}
+
+constexpr malib::shell::command_table commands{
+    malib::shell::command{"echo", &echo},
+    malib::shell::command{"ping",
+                          [](std::string_view, malib::shell::arguments,
+                             auto& output) {
+                            return output.write("pong").error_or(
+                                malib::Error::Ok);
+                          }},
+    malib::shell::command{"count",
+                          [](std::string_view, malib::shell::arguments args,
+                             auto& output) {
+                            auto text = std::to_string(args.size());
+                            return output.write(text).error_or(
+                                malib::Error::Ok);
+                          }},
+    malib::shell::command{"fail",
+                          [](std::string_view, malib::shell::arguments,
+                             auto& output) {
+                            output.write("failed");
+                            return malib::Error::InvalidArgument;
+                          }},
+};
+}  // namespace
+
+void test_PerfectHash_find() {
+  constexpr malib::PerfectHash<4> hash{
+      std::array<std::string_view, 4>{"alpha", "beta", "", "delta"}};
+  static_assert(hash.find("beta").value() == 1);
+  static_assert(hash.find("delta").value() == 3);
+  static_assert(!hash.find("").has_value());
+  static_assert(!hash.find("gamma").has_value());
+  TEST_ASSERT_EQUAL(0, hash.find("alpha").value());
+  TEST_ASSERT_EQUAL(8, hash.table_size());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument, hash.find("alph").error());
+}
+
+void test_StaticShell_find() {
+  static_assert(commands.size() == 4);
+  static_assert(commands.find("ping").value() == 1);
+  static_assert(commands.find("pin").error() == malib::Error::InvalidCommand);
+  TEST_ASSERT_EQUAL_STRING("count", commands.name(2).data());
+}
+
+void test_StaticShell_execute() {
+  malib::shell::static_tiny shell{commands};
+  string_output output{};
+
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("ping", output));
+  TEST_ASSERT_EQUAL_STRING("pong", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.execute("echo a \"b c\"", output));
+  TEST_ASSERT_EQUAL_STRING("a\"b c\"", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.execute("  count 1 2 3", output));
+  TEST_ASSERT_EQUAL_STRING("3", output.output.c_str());
+}
+
+void test_StaticShell_errors() {
+  malib::shell::static_tiny shell{commands};
+  string_output output{};
+
+  TEST_ASSERT_EQUAL(malib::Error::EmptyInput, shell.execute(" \t", output));
+  TEST_ASSERT_EQUAL(malib::Error::InvalidCommand,
+                    shell.execute("PING", output));
+  TEST_ASSERT_EQUAL_STRING("Invalid command\n", output.output.c_str());
+
+  output.output.clear();
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("fail", output));
+  TEST_ASSERT_EQUAL_STRING("failed", output.output.c_str());
+
+  TEST_ASSERT_TRUE(shell.isCommandValid("echo"));
+  TEST_ASSERT_FALSE(shell.isCommandValid("echo2"));
+}
+
+void test_StaticShell_outputBuffer() {
+  constexpr malib::shell::command_table table{
+      malib::shell::command{"long", [](std::string_view,
+                                        malib::shell::arguments, auto& output) {
+        return output.write("too long").error_or(malib::Error::Ok);
+      }}};
+  using table_type = std::remove_cvref_t<decltype(table)>;
+  malib::shell::static_tiny<table_type, malib::FixedStringBuffer<4>> shell{
+      table};
+  string_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded,
+                    shell.execute("long", output));
+}
+
+void test_StaticShell_session() {
+  const malib::shell::static_tiny shell{commands};
+  decltype(shell)::session_type session{};
+  string_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.execute(session, "count a b", output));
+  TEST_ASSERT_EQUAL_STRING("2", output.output.c_str());
+}
+
+void test_StaticShell_pipeline() {
+  malib::shell::static_tiny shell{commands};
+  string_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    shell.executeScript("ping | count a\necho x", output));
+  TEST_ASSERT_EQUAL_STRING("2x", output.output.c_str());
+}
+
+void test_StaticShell_typedCommand() {
+  constexpr malib::shell::command_table table{
+      malib::shell::command{
+          "scale", malib::shell::typed_command{[](auto& output, unsigned value,
+                                                  float factor) {
+            return malib::format_to<"{}">(output, value * factor)
+                .error_or(malib::Error::Ok);
+          }}}};
+  using table_type = std::remove_cvref_t<decltype(table)>;
+  malib::shell::static_tiny<table_type> shell{table};
+  string_output output{};
+  TEST_ASSERT_EQUAL(malib::Error::Ok, shell.execute("scale 4 1.5", output));
+  TEST_ASSERT_EQUAL_STRING("6", output.output.c_str());
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    shell.execute("scale -1 2", output));
+}
+
+void test_StaticShell() {
+  RUN_TEST(test_PerfectHash_find);
+  RUN_TEST(test_StaticShell_find);
+  RUN_TEST(test_StaticShell_execute);
+  RUN_TEST(test_StaticShell_errors);
+  RUN_TEST(test_StaticShell_outputBuffer);
+  RUN_TEST(test_StaticShell_session);
+  RUN_TEST(test_StaticShell_pipeline);
+  RUN_TEST(test_StaticShell_typedCommand);
+}
@@ -0,0 +1,135 @@
+#include <unity.h>
+
+#include <malib/StreamTokenizer.hpp>
+#include <malib/Tokenizer.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+template <typename Stream>
+std::vector<std::string> feed_all(Stream& stream,
+                                  const std::vector<std::string_view>& chunks) {
+  std::vector<std::string> tokens{};
+  auto collect = [&](std::string_view token) { tokens.emplace_back(token); };
+  for (auto chunk : chunks) {
+    auto result = stream.feed(chunk, collect);
+    TEST_ASSERT_TRUE(result.has_value());
+  }
+  stream.finish(collect);
+  return tokens;
+}
+}  // namespace
+
+void test_StreamTokenizer_single_chunk() {
+  malib::StreamTokenizer<16> stream{};
+  auto tokens = feed_all(stream, {"ls -al  /tmp"});
+  TEST_ASSERT_EQUAL(3, tokens.size());
+  TEST_ASSERT_EQUAL_STRING("ls", tokens[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("-al", tokens[1].c_str());
+  TEST_ASSERT_EQUAL_STRING("/tmp", tokens[2].c_str());
+}
+
+void test_StreamTokenizer_token_across_chunks() {
+  malib::StreamTokenizer<16> stream{};
+  std::vector<std::string> tokens{};
+  auto collect = [&](std::string_view token) { tokens.emplace_back(token); };
+
+  auto result = stream.feed("echo hel", collect);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(1, result.value());
+  TEST_ASSERT_EQUAL(3, stream.pending());
+
+  result = stream.feed("lo wor", collect);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(1, result.value());
+
+  result = stream.feed("ld", collect);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(0, result.value());
+  TEST_ASSERT_EQUAL(1, stream.finish(collect));
+
+  TEST_ASSERT_EQUAL(3, tokens.size());
+  TEST_ASSERT_EQUAL_STRING("echo", tokens[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("hello", tokens[1].c_str());
+  TEST_ASSERT_EQUAL_STRING("world", tokens[2].c_str());
+  TEST_ASSERT_EQUAL(0, stream.pending());
+}
+
+void test_StreamTokenizer_quote_across_chunks() {
+  malib::StreamTokenizer<32> stream{};
+  std::vector<std::string> tokens{};
+  auto collect = [&](std::string_view token) { tokens.emplace_back(token); };
+
+  stream.feed("say \"hello ", collect);
+  TEST_ASSERT_TRUE(stream.quoted());
+  stream.feed("big world\" now", collect);
+  TEST_ASSERT_FALSE(stream.quoted());
+  stream.finish(collect);
+
+  TEST_ASSERT_EQUAL(3, tokens.size());
+  TEST_ASSERT_EQUAL_STRING("\"hello big world\"", tokens[1].c_str());
+  TEST_ASSERT_EQUAL_STRING("now", tokens[2].c_str());
+}
+
+void test_StreamTokenizer_escape_across_chunks() {
+  malib::StreamTokenizer<16, malib::char_classes::shell_escaped> stream{};
+  auto tokens = feed_all(stream, {"a\\", " b c"});
+  TEST_ASSERT_EQUAL(2, tokens.size());
+  TEST_ASSERT_EQUAL_STRING("a\\ b", tokens[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("c", tokens[1].c_str());
+}
+
+void test_StreamTokenizer_token_too_long() {
+  malib::StreamTokenizer<4> stream{};
+  auto ignore = [](std::string_view) {};
+
+  // Tokens inside a single chunk are not limited
+  auto result = stream.feed("abcdefgh ", ignore);
+  TEST_ASSERT_TRUE(result.has_value());
+
+  result = stream.feed("abc", ignore);
+  TEST_ASSERT_TRUE(result.has_value());
+  result = stream.feed("de", ignore);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::MaximumSizeExceeded, result.error());
+
+  stream.reset();
+  TEST_ASSERT_EQUAL(0, stream.pending());
+}
+
+void test_StreamTokenizer_matches_tokenizer() {
+  const std::string input =
+      "set name \"quoted value\" 'single quoted' path=/a/b/c   count 42 "
+      "\"unterminated tail";
+  malib::Tokenizer<32> tokenizer{};
+  auto count = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(count.has_value());
+
+  for (std::size_t chunk_size = 1; chunk_size <= 9; ++chunk_size) {
+    std::vector<std::string_view> chunks{};
+    std::string_view rest = input;
+    while (!rest.empty()) {
+      chunks.push_back(rest.substr(0, chunk_size));
+      rest.remove_prefix(std::min(chunk_size, rest.size()));
+    }
+
+    malib::StreamTokenizer<64> stream{};
+    auto tokens = feed_all(stream, chunks);
+    TEST_ASSERT_EQUAL(count.value(), tokens.size());
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+      auto expected = tokenizer[i]->view(input);
+      TEST_ASSERT_EQUAL(expected.size(), tokens[i].size());
+      TEST_ASSERT_EQUAL_STRING_LEN(expected.data(), tokens[i].data(),
+                                   expected.size());
+    }
+  }
+}
+
+void test_StreamTokenizer() {
+  RUN_TEST(test_StreamTokenizer_single_chunk);
+  RUN_TEST(test_StreamTokenizer_token_across_chunks);
+  RUN_TEST(test_StreamTokenizer_quote_across_chunks);
+  RUN_TEST(test_StreamTokenizer_escape_across_chunks);
+  RUN_TEST(test_StreamTokenizer_token_too_long);
+  RUN_TEST(test_StreamTokenizer_matches_tokenizer);
+}
@@ -39,10 +39,111 @@ void test_StringConverter_ResultOutOfRange() {
   TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange, result);
 }
 
+void test_StringConverter_FloatErrors() {
+  double d = 1.0;
+  TEST_ASSERT_EQUAL(malib::Error::InvalidArgument,
+                    malib::StringConverter::to_number("x1.5", d));
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange,
+                    malib::StringConverter::to_number("1e999", d));
+  TEST_ASSERT_EQUAL_DOUBLE(1.0, d);
+
+  // Leading whitespace and '+' are accepted like strtod
+  TEST_ASSERT_EQUAL(malib::Error::Ok,
+                    malib::StringConverter::to_number("  +2.5", d));
+  TEST_ASSERT_EQUAL_DOUBLE(2.5, d);
+}
+
+namespace {
+template <typename T>
+constexpr T parse_constant(std::string_view input, int radix = 10) {
+  T value{};
+  if constexpr (std::floating_point<T>) {
+    malib::StringConverter::to_number(input, value);
+  } else {
+    malib::StringConverter::to_number(input, value, radix);
+  }
+  return value;
+}
+
+template <typename T>
+constexpr malib::Error parse_error(std::string_view input) {
+  T value{};
+  return malib::StringConverter::to_number(input, value);
+}
+}  // namespace
+
+void test_StringConverter_Constexpr() {
+  static_assert(parse_constant<int>("1234") == 1234);
+  static_assert(parse_constant<int>("-42abc") == -42);
+  static_assert(parse_constant<int8_t>("-128") == -128);
+  static_assert(parse_constant<uint32_t>("ff", 16) == 0xff);
+  static_assert(parse_error<int16_t>("32768") ==
+                malib::Error::ResultOutOfRange);
+  static_assert(parse_error<uint8_t>("-1") == malib::Error::InvalidArgument);
+  static_assert(parse_error<int>("") == malib::Error::InvalidArgument);
+
+  static_assert(parse_constant<double>("123.45") == 123.45);
+  static_assert(parse_constant<double>(" -0.001e2") == -0.1);
+  static_assert(parse_constant<float>("3.5") == 3.5f);
+  static_assert(parse_constant<double>("1e300") == 1e300);
+  static_assert(parse_error<float>("1e39") == malib::Error::ResultOutOfRange);
+  static_assert(parse_error<double>(".") == malib::Error::InvalidArgument);
+
+  // Compile time and run time agree
+  double runtime = 0.0;
+  malib::StringConverter::to_number("123.45", runtime);
+  TEST_ASSERT_TRUE(runtime == parse_constant<double>("123.45"));
+}
+
+namespace {
+template <typename T>
+constexpr malib::Error exact_error(std::string_view input) {
+  T value{};
+  return malib::StringConverter::to_number_exact(input, value);
+}
+}  // namespace
+
+void test_StringConverter_Exact() {
+  using malib::Error;
+  static_assert(exact_error<int>("-42") == Error::Ok);
+  static_assert(exact_error<int>("-42abc") == Error::InvalidArgument);
+  static_assert(exact_error<int>("2.9") == Error::InvalidArgument);
+  static_assert(exact_error<double>("2.5e3") == Error::Ok);
+  static_assert(exact_error<double>("2.5e") == Error::InvalidArgument);
+  static_assert(exact_error<double>("-infinity") == Error::Ok);
+  static_assert(exact_error<double>("1.5x") == Error::InvalidArgument);
+
+  int i = 0;
+  TEST_ASSERT_EQUAL(Error::Ok,
+                    malib::StringConverter::to_number_exact("-42", i));
+  TEST_ASSERT_EQUAL(-42, i);
+  TEST_ASSERT_EQUAL(Error::InvalidArgument,
+                    malib::StringConverter::to_number_exact("1x", i));
+  TEST_ASSERT_EQUAL(Error::InvalidArgument,
+                    malib::StringConverter::to_number_exact("2.9", i));
+  TEST_ASSERT_EQUAL(Error::ResultOutOfRange,
+                    malib::StringConverter::to_number_exact("99999999999", i));
+  TEST_ASSERT_EQUAL(Error::Ok,
+                    malib::StringConverter::to_number_exact("ff", i, 16));
+  TEST_ASSERT_EQUAL(255, i);
+
+  double d = 0.0;
+  TEST_ASSERT_EQUAL(Error::Ok,
+                    malib::StringConverter::to_number_exact(" +2.5e1", d));
+  TEST_ASSERT_EQUAL_DOUBLE(25.0, d);
+  TEST_ASSERT_EQUAL(Error::InvalidArgument,
+                    malib::StringConverter::to_number_exact("2.5 ", d));
+  TEST_ASSERT_EQUAL(Error::InvalidArgument,
+                    malib::StringConverter::to_number_exact("", d));
+}
+
 void test_StringConverter() {
   RUN_TEST(test_StringConverter_ToInt16);
   RUN_TEST(test_StringConverter_ToInt32);
   RUN_TEST(test_StringConverter_ToFloat);
   RUN_TEST(test_StringConverter_InvalidArgument);
   RUN_TEST(test_StringConverter_ResultOutOfRange);
+  RUN_TEST(test_StringConverter_FloatErrors);
+  RUN_TEST(test_StringConverter_Constexpr);
+  RUN_TEST(test_StringConverter_Exact);
 }
@@ -1,7 +1,9 @@
 #include <unity.h>
 
+#include <array>
 #include <malib/Error.hpp>
 #include <malib/Token.hpp>
+#include <string>
 #include <vector>
 
 void test_token_empty() {
@@ -37,6 +39,24 @@ void test_token_default_initialize() {
   TEST_ASSERT_TRUE(tok.empty());
 }
 
+void test_token_fits() {
+  TEST_ASSERT_EQUAL(0xFFFFFF, malib::Token::max_offset);
+  TEST_ASSERT_EQUAL(0xFF, malib::Token::max_length);
+  TEST_ASSERT_TRUE(malib::Token::fits(0xFFFFFF, 0xFF));
+  TEST_ASSERT_FALSE(malib::Token::fits(0x1000000, 0));
+  TEST_ASSERT_FALSE(malib::Token::fits(0, 0x100));
+}
+
+void test_wide_token_fits() {
+  TEST_ASSERT_EQUAL(8, sizeof(malib::WideToken));
+  TEST_ASSERT_TRUE(malib::WideToken::fits(0x1000000, 0x100));
+  TEST_ASSERT_TRUE(malib::WideToken::fits(0xFFFFFFFF, 0xFFFFFFFF));
+
+  std::string base(300, 'x');
+  malib::WideToken tok{10, 280};
+  TEST_ASSERT_EQUAL(280, tok.view(base).size());
+}
+
 void test_tokenviews_empty() {
   std::string_view base = "";
   std::vector<malib::Token> tokens;
@@ -121,6 +141,18 @@ void test_tokenviews_subspan() {
   TEST_ASSERT_EQUAL(2, views->size());
 }
 
+void test_tokenviews_constexpr() {
+  static constexpr std::array<malib::Token, 2> tokens{{{0, 3}, {4, 2}}};
+  constexpr auto views = malib::TokenViews::create("cmd ok", tokens);
+  static_assert(views.has_value());
+  static_assert(views->size() == 2);
+  static_assert(*(*views)[1] == "ok");
+
+  static constexpr std::array<malib::Token, 1> invalid{{{4, 8}}};
+  static_assert(!malib::TokenViews::create("cmd ok", invalid).has_value());
+  TEST_ASSERT_EQUAL(2, views->size());
+}
+
 void test_TokenViews() {
   RUN_TEST(test_tokenviews_empty);
   RUN_TEST(test_tokenviews_iteration);
@@ -130,6 +162,7 @@ void test_TokenViews() {
   RUN_TEST(test_tokenviews_overlapping_tokens);
   RUN_TEST(test_tokenviews_unordered_tokens);
   RUN_TEST(test_tokenviews_subspan);
+  RUN_TEST(test_tokenviews_constexpr);
 }
 
 void test_Token() {
@@ -138,5 +171,7 @@ void test_Token() {
   RUN_TEST(test_token_view_edge_case_single_char);
   RUN_TEST(test_token_view_edge_case_full_string);
   RUN_TEST(test_token_default_initialize);
+  RUN_TEST(test_token_fits);
+  RUN_TEST(test_wide_token_fits);
   test_TokenViews();
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <unity.h>
+
+#include <array>
+#include <malib/TokenDecoder.hpp>
+#include <malib/Tokenizer.hpp>
+#include <span>
+
+using Decoder = malib::TokenDecoder<>;
+
+void test_TokenDecoder_plain_token_is_not_copied() {
+  std::string_view token = "plain";
+  std::array<char, 8> storage{};
+  std::span<char> arena{storage};
+
+  auto result = Decoder::decode(token, arena);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->data() == token.data());
+  TEST_ASSERT_EQUAL(5, result->size());
+  TEST_ASSERT_EQUAL(8, arena.size());
+}
+
+void test_TokenDecoder_quoted_token_is_not_copied() {
+  std::string_view token = "\"hello world\"";
+  std::array<char, 4> storage{};
+  std::span<char> arena{storage};
+
+  auto result = Decoder::decode(token, arena);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->data() == token.data() + 1);
+  TEST_ASSERT_EQUAL_STRING_LEN("hello world", result->data(), 11);
+  TEST_ASSERT_EQUAL(11, result->size());
+  TEST_ASSERT_EQUAL(4, arena.size());
+
+  result = Decoder::decode("''", arena);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_TRUE(result->empty());
+}
+
+void test_TokenDecoder_escapes_are_decoded() {
+  std::array<char, 32> storage{};
+  std::span<char> arena{storage};
+
+  auto first = Decoder::decode("a\\ b", arena);
+  TEST_ASSERT_TRUE(first.has_value());
+  TEST_ASSERT_EQUAL(3, first->size());
+  TEST_ASSERT_EQUAL_STRING_LEN("a b", first->data(), 3);
+  TEST_ASSERT_EQUAL(29, arena.size());
+
+  auto second = Decoder::decode("\"say \\\"hi\\\"\"", arena);
+  TEST_ASSERT_TRUE(second.has_value());
+  TEST_ASSERT_EQUAL(8, second->size());
+  TEST_ASSERT_EQUAL_STRING_LEN("say \"hi\"", second->data(), 8);
+
+  // Earlier results stay valid while the arena is consumed
+  TEST_ASSERT_EQUAL_STRING_LEN("a b", first->data(), 3);
+
+  auto mixed = Decoder::decode("key='a b'c", arena);
+  TEST_ASSERT_TRUE(mixed.has_value());
+  TEST_ASSERT_EQUAL_STRING_LEN("key=a bc", mixed->data(), 8);
+
+  auto trailing = Decoder::decode("end\\", arena);
+  TEST_ASSERT_TRUE(trailing.has_value());
+  TEST_ASSERT_EQUAL(4, trailing->size());
+}
+
+void test_TokenDecoder_arena_too_small() {
+  std::array<char, 2> storage{};
+  std::span<char> arena{storage};
+
+  auto result = Decoder::decode("a\\ b", arena);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::BufferFull, result.error());
+  TEST_ASSERT_EQUAL(2, arena.size());
+}
+
+void test_TokenDecoder_tokenizer_decode() {
+  std::string_view input = "echo \"hello world\" it\\'s plain";
+  malib::Tokenizer<8, malib::char_classes::shell_escaped> tokenizer{};
+  auto count = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(count.has_value());
+  TEST_ASSERT_EQUAL(4, count.value());
+
+  std::array<char, 16> storage{};
+  std::span<char> arena{storage};
+
+  auto quoted = tokenizer.decode(input, 1, arena);
+  TEST_ASSERT_TRUE(quoted.has_value());
+  TEST_ASSERT_EQUAL_STRING_LEN("hello world", quoted->data(), 11);
+
+  auto escaped = tokenizer.decode(input, 2, arena);
+  TEST_ASSERT_TRUE(escaped.has_value());
+  TEST_ASSERT_EQUAL(4, escaped->size());
+  TEST_ASSERT_EQUAL_STRING_LEN("it's", escaped->data(), 4);
+  TEST_ASSERT_EQUAL(12, arena.size());
+
+  auto missing = tokenizer.decode(input, 4, arena);
+  TEST_ASSERT_FALSE(missing.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::IndexOutOfRange, missing.error());
+}
+
+void test_TokenDecoder() {
+  RUN_TEST(test_TokenDecoder_plain_token_is_not_copied);
+  RUN_TEST(test_TokenDecoder_quoted_token_is_not_copied);
+  RUN_TEST(test_TokenDecoder_escapes_are_decoded);
+  RUN_TEST(test_TokenDecoder_arena_too_small);
+  RUN_TEST(test_TokenDecoder_tokenizer_decode);
+}
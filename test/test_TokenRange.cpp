@@ -0,0 +1,89 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <malib/TokenRange.hpp>
+#include <malib/Tokenizer.hpp>
+#include <ranges>
+#include <string>
+
+void test_TokenRange_iteration() {
+  malib::TokenRange<> range{"  ls -al   \"my dir\" "};
+  auto it = range.begin();
+  TEST_ASSERT_FALSE(it == range.end());
+  TEST_ASSERT_EQUAL_STRING_LEN("ls", (*it).data(), 2);
+  ++it;
+  TEST_ASSERT_EQUAL_STRING_LEN("-al", (*it).data(), 3);
+  ++it;
+  TEST_ASSERT_EQUAL(8, (*it).size());
+  TEST_ASSERT_EQUAL_STRING_LEN("\"my dir\"", (*it).data(), 8);
+  ++it;
+  TEST_ASSERT_TRUE(it == range.end());
+}
+
+void test_TokenRange_empty() {
+  TEST_ASSERT_TRUE(malib::TokenRange<>{""}.empty());
+  TEST_ASSERT_TRUE(malib::TokenRange<>{" \t\n "}.empty());
+  TEST_ASSERT_FALSE(malib::TokenRange<>{" x "}.empty());
+}
+
+void test_TokenRange_no_token_limit() {
+  std::string input{};
+  for (int i = 0; i < 1000; ++i) {
+    input += "t ";
+  }
+  auto count = std::ranges::distance(malib::TokenRange<>{input});
+  TEST_ASSERT_EQUAL(1000, count);
+}
+
+void test_TokenRange_ranges_adaptors() {
+  std::string_view input = "set a=1 b=2 c=3";
+  auto args = malib::TokenRange<>{input} | std::views::drop(1) |
+              std::views::take(2);
+  std::string joined{};
+  for (auto token : args) {
+    joined.append(token);
+    joined.push_back(';');
+  }
+  TEST_ASSERT_EQUAL_STRING("a=1;b=2;", joined.c_str());
+}
+
+void test_TokenRange_custom_classes() {
+  malib::TokenRange<malib::char_classes::key_value> range{"a=1; b=\"x y\""};
+  auto it = std::ranges::next(range.begin(), 3);
+  TEST_ASSERT_EQUAL_STRING_LEN("\"x y\"", (*it).data(), 5);
+}
+
+void test_TokenRange_matches_tokenizer() {
+  const std::string input =
+      "a\\ b 'single quoted' \"double \\\" quoted\"  tail \"unterminated";
+  malib::Tokenizer<16, malib::char_classes::shell_escaped> tokenizer{};
+  auto count = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(count.has_value());
+
+  std::size_t i = 0;
+  for (auto token :
+       malib::TokenRange<malib::char_classes::shell_escaped>{input}) {
+    auto expected = tokenizer[i++]->view(input);
+    TEST_ASSERT_EQUAL(expected.size(), token.size());
+    TEST_ASSERT_EQUAL_STRING_LEN(expected.data(), token.data(), token.size());
+  }
+  TEST_ASSERT_EQUAL(count.value(), i);
+}
+
+void test_TokenRange_constexpr() {
+  constexpr auto count = std::ranges::distance(malib::TokenRange<>{"a b c"});
+  static_assert(count == 3);
+  constexpr auto first = *malib::TokenRange<>{" cmd arg"}.begin();
+  static_assert(first == "cmd");
+  TEST_ASSERT_EQUAL(3, count);
+}
+
+void test_TokenRange() {
+  RUN_TEST(test_TokenRange_iteration);
+  RUN_TEST(test_TokenRange_empty);
+  RUN_TEST(test_TokenRange_no_token_limit);
+  RUN_TEST(test_TokenRange_ranges_adaptors);
+  RUN_TEST(test_TokenRange_custom_classes);
+  RUN_TEST(test_TokenRange_matches_tokenizer);
+  RUN_TEST(test_TokenRange_constexpr);
+}
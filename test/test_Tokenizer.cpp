@@ -1,5 +1,8 @@
 #include <unity.h>
 
+#include <string>
+#include <vector>
+
 #include "malib/Error.hpp"
 #include "malib/Tokenizer.hpp"
 
@@ -94,6 +97,178 @@ void test_tokenizer_element_access_out_of_bounds() {
   TEST_ASSERT_EQUAL(malib::Error::IndexOutOfRange, token.error());
 }
 
+void test_tokenizer_tokenize_trailing_whitespace() {
+  using SmallTokenizer = malib::Tokenizer<10>;
+  SmallTokenizer tokenizer{};
+  auto result = tokenizer.tokenize("  ls \t-al \r\n  ");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_INT(2, result.value());
+  TEST_ASSERT_EQUAL(2, tokenizer[0].value().offset);
+  TEST_ASSERT_EQUAL(6, tokenizer[1].value().offset);
+  TEST_ASSERT_EQUAL(3, tokenizer[1].value().length);
+
+  result = tokenizer.tokenize(" \t\n ");
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_INT(0, result.value());
+}
+
+void test_tokenizer_tokenize_long_input_across_blocks() {
+  // Quoted tokens straddle the 16/32/64 byte block boundaries used by the
+  // vectorized path
+  std::string input{};
+  std::vector<std::string> expected{};
+  for (int i = 0; i < 40; i++) {
+    std::string token = "arg" + std::to_string(i);
+    if (i % 3 == 0) {
+      token = "\"quoted value " + std::to_string(i) + "\"";
+    } else if (i % 5 == 0) {
+      token = "k='a b\tc'";
+    }
+    input += token;
+    input += (i % 2 == 0) ? "   " : "\t";
+    expected.push_back(token);
+  }
+
+  malib::Tokenizer<64> tokenizer{};
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(expected.size(), result.value());
+
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    auto view = tokenizer[i].value().view(input);
+    TEST_ASSERT_EQUAL(expected[i].size(), view.size());
+    TEST_ASSERT_EQUAL_STRING_LEN(expected[i].c_str(), view.data(),
+                                 view.size());
+  }
+}
+
+void test_tokenizer_tokenize_unclosed_quote() {
+  std::string input = "echo \"unclosed quote";
+  input += std::string(100, ' ');
+  input += "still quoted";
+
+  malib::Tokenizer<4> tokenizer{};
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_INT(2, result.value());
+  TEST_ASSERT_EQUAL(5, tokenizer[1].value().offset);
+}
+
+template <typename T>
+static void assert_tokens(const T& tokenizer, std::string_view input,
+                          const std::vector<std::string_view>& expected) {
+  auto tokens = tokenizer.tokens_span();
+  TEST_ASSERT_EQUAL(expected.size(), tokens.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    auto view = tokens[i].view(input);
+    TEST_ASSERT_EQUAL(expected[i].size(), view.size());
+    TEST_ASSERT_EQUAL_STRING_LEN(expected[i].data(), view.data(), view.size());
+  }
+}
+
+void test_tokenizer_char_class_table() {
+  constexpr auto table = malib::make_char_classes(",;", "\"", "\\");
+  static_assert(table.is(',', malib::CharClass::Separator));
+  static_assert(table.is('"', malib::CharClass::Quote));
+  static_assert(table.is('\\', malib::CharClass::Escape));
+  static_assert(!table.is(' ', malib::CharClass::Separator));
+  static_assert(table.members(malib::CharClass::Separator).size == 2);
+}
+
+void test_tokenizer_csv_classes() {
+  malib::Tokenizer<8, malib::char_classes::csv> tokenizer{};
+  std::string_view input = "id,\"name, with comma\",value\r\n";
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  assert_tokens(tokenizer, input, {"id", "\"name, with comma\"", "value"});
+}
+
+void test_tokenizer_key_value_classes() {
+  malib::Tokenizer<8, malib::char_classes::key_value> tokenizer{};
+  std::string_view input = "mode=fast; level = 3, name='a=b'";
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  assert_tokens(tokenizer, input,
+                {"mode", "fast", "level", "3", "name", "'a=b'"});
+}
+
+void test_tokenizer_pipeline_classes() {
+  malib::Tokenizer<8, malib::char_classes::pipeline> tokenizer{};
+  std::string_view input = "cat log | grep 'a|b' | wc";
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  assert_tokens(tokenizer, input, {"cat log ", " grep 'a|b' ", " wc"});
+}
+
+void test_tokenizer_escapes() {
+  malib::Tokenizer<8, malib::char_classes::shell_escaped> tokenizer{};
+  std::string_view input = R"(echo a\ b "say \"hi there\"" c\\ d)";
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  assert_tokens(tokenizer, input,
+                {"echo", R"(a\ b)", R"("say \"hi there\"")", R"(c\\)", "d"});
+}
+
+void test_tokenizer_escapes_across_blocks() {
+  // A run of escapes that straddles the 64 byte block boundary
+  std::string input(62, 'x');
+  input += "\\\\\\ y z";
+
+  malib::Tokenizer<4, malib::char_classes::shell_escaped> tokenizer{};
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL_INT(2, result.value());
+  TEST_ASSERT_EQUAL(67, tokenizer[0].value().length);
+}
+
+void test_tokenizer_token_too_long() {
+  const std::string input = "echo " + std::string(300, 'a');
+  malib::Tokenizer<4> tokenizer{};
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_FALSE(result.has_value());
+  TEST_ASSERT_EQUAL(malib::Error::ResultOutOfRange, result.error());
+}
+
+void test_tokenizer_wide_tokens() {
+  const std::string input = "echo " + std::string(300, 'a') + " done";
+  malib::WideTokenizer<4> tokenizer{};
+  auto result = tokenizer.tokenize(input);
+  TEST_ASSERT_TRUE(result.has_value());
+  TEST_ASSERT_EQUAL(3, result.value());
+  TEST_ASSERT_EQUAL(300, tokenizer[1]->length);
+
+  auto views = tokenizer.tokens_views(input);
+  TEST_ASSERT_TRUE(views.has_value());
+  TEST_ASSERT_EQUAL(300, (*views)[1]->size());
+  TEST_ASSERT_EQUAL_STRING_LEN("done", (*views)[2]->data(), 4);
+}
+
+void test_tokenizer_constexpr() {
+  constexpr auto tokenizer = [] {
+    malib::Tokenizer<4> tokenizer{};
+    tokenizer.tokenize("set  \"a b\" 42");
+    return tokenizer;
+  }();
+  static_assert(tokenizer.tokens_span().size() == 3);
+  static_assert(tokenizer[1]->offset == 5);
+  static_assert(tokenizer[1]->length == 5);
+
+  constexpr auto overflow = [] {
+    malib::Tokenizer<1> tokenizer{};
+    return tokenizer.tokenize("a b").error_or(malib::Error::Ok);
+  }();
+  static_assert(overflow == malib::Error::MaximumSizeExceeded);
+
+  constexpr std::string_view input = "led on 50";
+  constexpr auto second = [&] {
+    malib::Tokenizer<4> tokenizer{};
+    tokenizer.tokenize(input);
+    return std::string_view{*(*tokenizer.tokens_views(input))[1]};
+  }();
+  static_assert(second == "on");
+  TEST_ASSERT_EQUAL(3, tokenizer.tokens_span().size());
+}
+
 void test_Tokenizer() {
   RUN_TEST(test_tokenizer_tokenize_ls_al);
   RUN_TEST(test_tokenizer_tokenize_ls_al_h);
@@ -104,4 +279,16 @@ void test_Tokenizer() {
   RUN_TEST(test_tokenizer_tokenize_empty_string);
   RUN_TEST(test_tokenizer_element_access_ls_al);
   RUN_TEST(test_tokenizer_element_access_out_of_bounds);
+  RUN_TEST(test_tokenizer_tokenize_trailing_whitespace);
+  RUN_TEST(test_tokenizer_tokenize_long_input_across_blocks);
+  RUN_TEST(test_tokenizer_tokenize_unclosed_quote);
+  RUN_TEST(test_tokenizer_char_class_table);
+  RUN_TEST(test_tokenizer_csv_classes);
+  RUN_TEST(test_tokenizer_key_value_classes);
+  RUN_TEST(test_tokenizer_pipeline_classes);
+  RUN_TEST(test_tokenizer_escapes);
+  RUN_TEST(test_tokenizer_escapes_across_blocks);
+  RUN_TEST(test_tokenizer_token_too_long);
+  RUN_TEST(test_tokenizer_wide_tokens);
+  RUN_TEST(test_tokenizer_constexpr);
 }
\ No newline at end of file